@@ -1,13 +1,18 @@
 #include <algorithm>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <random>
 #include <string>
 
 #include <ofnx/files/lst.h>
 #include <ofnx/files/pak.h>
 #include <ofnx/tools/log.h>
 
+#include <engine/scriptimage.h>
+
 #ifdef _WIN32
 #include <windows.h>
 #endif
@@ -61,25 +66,72 @@ std::vector<uint8_t> readScript(const std::string& fileIn)
     return fvrPak.fileData(0);
 }
 
-void saveScript(const std::vector<uint8_t>& data, const std::string& fileOut)
+bool saveScript(const std::vector<uint8_t>& data, const std::string& fileOut, ofnx::files::Lst& fvrScript)
 {
-    const std::string tmpFileName = "tmp.lst";
-    std::ofstream fileTmp(tmpFileName, std::ios::binary);
+    // The parser only reads files, each script gets its own temporary one
+    const std::filesystem::path tmpFile = std::filesystem::temp_directory_path()
+        / ("louvre_" + std::filesystem::path(fileOut).stem().string() + "_" + std::to_string(std::random_device()()) + ".lst");
+    std::ofstream fileTmp(tmpFile, std::ios::binary);
     fileTmp.write(reinterpret_cast<const char*>(data.data()), data.size());
     fileTmp.close();
 
-    ofnx::files::Lst fvrScript;
-    if (!fvrScript.parseLst(tmpFileName)) {
-        LOG_ERROR("Error parsing script: {}", tmpFileName);
-        return;
+    const bool isParsed = fvrScript.parseLst(tmpFile.string());
+    std::error_code error;
+    std::filesystem::remove(tmpFile, error);
+    if (!isParsed) {
+        LOG_ERROR("Error parsing script: {}", fileOut);
+        return false;
     }
 
     if (!fvrScript.saveLst(fileOut)) {
         LOG_ERROR("Error saving script: {}", fileOut);
-        return;
+        return false;
     }
 
-    std::filesystem::remove(tmpFileName);
+    return true;
+}
+
+bool convertScript(const std::string& fileIn, const std::string& fileOut, ofnx::files::Lst& fvrScript)
+{
+    const std::vector<uint8_t> data = readScript(fileIn);
+    if (data.empty()) {
+        return false;
+    }
+
+    return saveScript(data, fileOut, fvrScript);
+}
+
+int readZoneCount(const std::string& pathTest, const std::string& warpName)
+{
+    // Zone count is the first field of the file
+    const std::string tstFile = pathTest + std::filesystem::path(warpName).stem().string() + ".tst";
+    uint32_t count = 0;
+    std::ifstream file(tstFile, std::ios::binary);
+    if (!file.read(reinterpret_cast<char*>(&count), sizeof(count))) {
+        return 0;
+    }
+
+    return (int)count;
+}
+
+void saveScriptImage(ofnx::files::Lst& fvrScript, const std::string& fileScript, const std::string& pathWarp, const std::string& pathTest)
+{
+    std::vector<std::string> warpNames;
+    for (const auto& entry : std::filesystem::directory_iterator(pathWarp)) {
+        if (entry.path().extension() == ".vr") {
+            warpNames.push_back(entry.path().filename().string());
+        }
+    }
+
+    const auto zoneCounter = [&pathTest](const std::string& warpName) {
+        return readZoneCount(pathTest, warpName);
+    };
+    const std::vector<uint8_t> data = ScriptImage::build(fvrScript, warpNames, zoneCounter, ScriptImage::sourceOf(fileScript, warpNames, zoneCounter));
+
+    const std::string fileOut = ScriptImage::imagePath(fileScript);
+    if (!ScriptImage::save(fileOut, data)) {
+        LOG_ERROR("Error saving script image: {}", fileOut);
+    }
 }
 
 void copyVideo(const std::string& path, const std::string& pathOut)
@@ -125,6 +177,12 @@ int main(int argc, char* argv[])
     std::filesystem::create_directories(pathOutTest);
     std::filesystem::create_directories(pathOutScript);
 
+    // Scripts, converted while the other files are copied
+    ofnx::files::Lst fvrScript1;
+    ofnx::files::Lst fvrScript2;
+    std::future<bool> script1 = std::async(std::launch::async, convertScript, pathData1 + "script.pak", pathOutScript + "script_1.lst", std::ref(fvrScript1));
+    std::future<bool> script2 = std::async(std::launch::async, convertScript, pathData2 + "script2.pak", pathOutScript + "script_2.lst", std::ref(fvrScript2));
+
     // Sounds
     copyFiles(pathInstall, pathOutAudio, ".wav");
     copyFiles(pathData1, pathOutAudio, ".wav");
@@ -147,13 +205,6 @@ int main(int argc, char* argv[])
     // Texts
     copyFile(pathInstall + "textes.txt", pathOut, ".txt");
 
-    // Scripts
-    std::vector<uint8_t> dataScript1 = readScript(pathData1 + "script.pak");
-    saveScript(dataScript1, pathOutScript + "script_1.lst");
-
-    std::vector<uint8_t> dataScript2 = readScript(pathData2 + "script2.pak");
-    saveScript(dataScript2, pathOutScript + "script_2.lst");
-
     // VR
     copyFiles(pathInstall, pathOutWarp, ".vr");
     copyFiles(pathData1, pathOutWarp, ".vr");
@@ -164,5 +215,13 @@ int main(int argc, char* argv[])
     copyFiles(pathData1, pathOutTest, ".tst");
     copyFiles(pathData2, pathOutTest, ".tst");
 
+    // Precompiled scripts, after the warps and zones they index
+    if (script1.get()) {
+        saveScriptImage(fvrScript1, pathOutScript + "script_1.lst", pathOutWarp, pathOutTest);
+    }
+    if (script2.get()) {
+        saveScriptImage(fvrScript2, pathOutScript + "script_2.lst", pathOutWarp, pathOutTest);
+    }
+
     return 0;
 }
@@ -1,3 +1,4 @@
+#include <cstring>
 #include <iostream>
 
 #include <engine.h>
@@ -15,6 +16,14 @@ int main(int argc, char* argv[])
 
     registerPluginLouvre(engine);
 
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--render-on-demand") == 0) {
+            engine.setRenderOnDemand(true);
+        } else if (std::strcmp(argv[i], "--profile-scripts") == 0) {
+            engine.setScriptProfiling(true);
+        }
+    }
+
     engine.loop();
     engine.deinit();
 
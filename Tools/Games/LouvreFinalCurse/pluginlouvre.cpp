@@ -239,7 +239,7 @@ struct LouvreData {
 
     int objectChest[CHEST_SIZE] = { -1 };
 
-    std::string isMonde4 = "0.0";
+    double isMonde4 = 0.0;
 
     ofnx::files::ArnVit arnVit;
 };
@@ -255,7 +255,7 @@ void drawImageToScreen(Engine& engine, const std::string& img, int x, int y)
         return;
     }
 
-    std::vector<uint16_t>& fb = engine.getFrameBuffer();
+    std::vector<uint16_t>& fb = engine.getFrameBuffer(x, y, file.width, file.height);
     uint16_t* imgData = (uint16_t*)file.data.data();
     for (int i = 0; i < file.height; ++i) {
         for (int j = 0; j < file.width; ++j) {
@@ -309,49 +309,32 @@ void printPortefSelectedObject(Engine& engine, int objectSlot)
 }
 
 /* Plugin */
-void plgPlayMovie(Engine& engine, std::vector<std::string> args)
+void plgPlayMovie(Engine& engine, const std::string& movie)
 {
-    if (args.size() != 1) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    std::string movie = args[0];
-
     engine.playMovie(movie);
 }
 
-void plgCmp(Engine& engine, std::vector<std::string> args)
+void plgCmp(Engine& engine, const std::string& cond, const std::string& notCond, const std::string& var, const std::string& op, double value)
 {
-    if (args.size() != 5) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    std::string cond = args[0];
-    std::string notCond = args[1];
-    std::string var = args[2];
-    std::string op = args[3];
-    double value = std::stod(args[4]);
     bool result = false;
     if (op == "==") {
-        result = std::stod(engine.getStateValue(var)) == value;
+        result = engine.getStateNumber(var) == value;
     } else if (op == "!=") {
-        result = std::stod(engine.getStateValue(var)) != value;
+        result = engine.getStateNumber(var) != value;
     } else if (op == "<") {
-        result = std::stod(engine.getStateValue(var)) < value;
+        result = engine.getStateNumber(var) < value;
     } else if (op == "<=") {
-        result = std::stod(engine.getStateValue(var)) <= value;
+        result = engine.getStateNumber(var) <= value;
     } else if (op == ">") {
-        result = std::stod(engine.getStateValue(var)) > value;
+        result = engine.getStateNumber(var) > value;
     } else if (op == ">=") {
-        result = std::stod(engine.getStateValue(var)) >= value;
+        result = engine.getStateNumber(var) >= value;
     } else {
         LOG_ERROR("Invalid operator: {}", op);
     }
 
-    engine.setStateValue(cond, result ? "1.0" : "0.0");
-    engine.setStateValue(notCond, result ? "0.0" : "1.0");
+    engine.setStateNumber(cond, result ? 1.0 : 0.0);
+    engine.setStateNumber(notCond, result ? 0.0 : 1.0);
 }
 
 void plgKillTimer(Engine& engine, std::vector<std::string> args)
@@ -360,45 +343,20 @@ void plgKillTimer(Engine& engine, std::vector<std::string> args)
     LOG_ERROR("Not implemented");
 }
 
-void plgCarteDestination(Engine& engine, std::vector<std::string> args)
+void plgCarteDestination(Engine& engine, const std::string& x, const std::string& y)
 {
-    if (args.size() != 2) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    std::string x = args[0];
-    std::string y = args[1];
-
     // TODO: implement
     LOG_ERROR("Not implemented");
 }
 
-void plgPauseTimer(Engine& engine, std::vector<std::string> args)
+void plgPauseTimer(Engine& engine, double timer, double value)
 {
-    if (args.size() != 2) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    double timer = std::stod(args[0]);
-    double value = std::stod(args[1]);
-
     // TODO: implement
     LOG_ERROR("Not implemented");
 }
 
-void plgAdd(Engine& engine, std::vector<std::string> args)
+void plgAdd(Engine& engine, const std::string& object, const std::string& cond, const std::string& notCond)
 {
-    if (args.size() != 3) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    std::string object = args[0];
-    std::string cond = args[1];
-    std::string notCond = args[2];
-
     // TODO: implement
     LOG_ERROR("Not implemented");
 }
@@ -409,14 +367,8 @@ void plgInitCoffre(Engine& engine, std::vector<std::string> args)
     LOG_ERROR("Not implemented");
 }
 
-void plgAffichePortef(Engine& engine, std::vector<std::string> args)
+void plgAffichePortef(Engine& engine, double value)
 {
-    if (args.size() != 1) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    double value = std::stod(args[0]);
     for (int i = 0; i < INVENTORY_SIZE; ++i) {
         if (g_louvreData.objectInventory[i] == -1) {
             // Skip empty slots
@@ -442,59 +394,25 @@ void plgAfficheCoffre(Engine& engine, std::vector<std::string> args)
     LOG_ERROR("Not implemented");
 }
 
-void plgScroll(Engine& engine, std::vector<std::string> args)
+void plgScroll(Engine& engine, double value)
 {
-    if (args.size() != 1) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    double value = std::stod(args[0]);
-
     // TODO: implement
     LOG_ERROR("Not implemented");
 }
 
-void plgSelectPorteF(Engine& engine, std::vector<std::string> args)
+void plgSelectPorteF(Engine& engine, double value, const std::string& z)
 {
-    if (args.size() != 2) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    double value = std::stod(args[0]);
-    std::string z = args[1];
-
     // TODO: implement
     LOG_ERROR("Not implemented");
 }
 
-void plgPlayAnimBloc(Engine& engine, std::vector<std::string> args)
+void plgPlayAnimBloc(Engine& engine, const std::string& name, const std::string& var, double frameCount, double speed)
 {
-    if (args.size() != 4) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    std::string name = args[0];
-    std::string var = args[1];
-    double frameCount = std::stod(args[2]);
-    double speed = std::stod(args[3]);
-
-    // TODO: implement correctly
-    engine.playAnim(name);
+    engine.playAnim(name, var, (int)frameCount, speed);
 }
 
-void plgUntilLoop(Engine& engine, std::vector<std::string> args)
+void plgUntilLoop(Engine& engine, const std::string& variable, double value)
 {
-    if (args.size() != 2) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    std::string variable = args[0];
-    double value = std::stod(args[1]);
-
     engine.untilLoop(variable, value);
 }
 
@@ -504,61 +422,26 @@ void plgMemoryRelease(Engine& engine, std::vector<std::string> args)
     LOG_ERROR("Not implemented");
 }
 
-void plgSelectCoffre(Engine& engine, std::vector<std::string> args)
+void plgSelectCoffre(Engine& engine, double value, const std::string& z)
 {
-    if (args.size() != 2) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    double value = std::stod(args[0]);
-    std::string z = args[1];
-
     // TODO: implement
     LOG_ERROR("Not implemented");
 }
 
-void plgPlayAnimBlocNumber(Engine& engine, std::vector<std::string> args)
+void plgPlayAnimBlocNumber(Engine& engine, const std::string& value, const std::string& y, const std::string& z, double value1, double value2)
 {
-    if (args.size() != 5) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    std::string value = args[0];
-    std::string y = args[1];
-    std::string z = args[2];
-    double value1 = std::stod(args[3]);
-    double value2 = std::stod(args[4]);
-
     // TODO: implement
     LOG_ERROR("Not implemented");
 }
 
-void plgSub(Engine& engine, std::vector<std::string> args)
+void plgSub(Engine& engine, const std::string& value, const std::string& y, double value2)
 {
-    if (args.size() != 3) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    std::string value = args[0];
-    std::string y = args[1];
-    double value2 = std::stod(args[2]);
-
     // TODO: implement
     LOG_ERROR("Not implemented");
 }
 
-void plgWhileLoop(Engine& engine, std::vector<std::string> args)
+void plgWhileLoop(Engine& engine, double timer)
 {
-    if (args.size() != 1) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    double timer = std::stod(args[0]);
-
     engine.whileLoop(timer);
 }
 
@@ -577,68 +460,31 @@ void plgDrawTextSelection(Engine& engine, std::vector<std::string> args)
     LOG_ERROR("Not implemented");
 }
 
-void plgPorteFRollover(Engine& engine, std::vector<std::string> args)
+void plgPorteFRollover(Engine& engine, double value)
 {
-    if (args.size() != 1) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    double value = std::stod(args[0]);
-
     // TODO: implement
     LOG_ERROR("Not implemented");
 }
 
-void plgSetMonde4(Engine& engine, std::vector<std::string> args)
+void plgSetMonde4(Engine& engine, double value)
 {
-    if (args.size() != 1) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    double value = std::stod(args[0]);
-
     g_louvreData.isMonde4 = value;
 }
 
-void plgGetMonde4(Engine& engine, std::vector<std::string> args)
+void plgGetMonde4(Engine& engine, const std::string& cond, const std::string& notCond)
 {
-    if (args.size() != 2) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    std::string cond = args[0];
-    std::string notCond = args[1];
-
-    engine.setStateValue(cond, g_louvreData.isMonde4);
-    engine.setStateValue(notCond, g_louvreData.isMonde4);
+    engine.setStateNumber(cond, g_louvreData.isMonde4);
+    engine.setStateNumber(notCond, g_louvreData.isMonde4 == 0.0 ? 1.0 : 0.0);
 }
 
-void plgChangeCurseur(Engine& engine, std::vector<std::string> args)
+void plgChangeCurseur(Engine& engine, double value)
 {
-    if (args.size() != 1) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    double value = std::stod(args[0]);
-
     // TODO: implement
     LOG_ERROR("Not implemented");
 }
 
-void plgLoadSaveContextRestored(Engine& engine, std::vector<std::string> args)
+void plgLoadSaveContextRestored(Engine& engine, const std::string& reloading, const std::string& reloadDone)
 {
-    if (args.size() != 2) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    std::string reloading = args[0];
-    std::string reloadDone = args[1];
-
     // TODO: implement
     LOG_ERROR("Not implemented");
 }
@@ -649,41 +495,20 @@ void plgLoadSaveCaptureContext(Engine& engine, std::vector<std::string> args)
     LOG_ERROR("Not implemented");
 }
 
-void plgLoadSaveInitSlots(Engine& engine, std::vector<std::string> args)
+void plgLoadSaveInitSlots(Engine& engine, double value)
 {
-    if (args.size() != 1) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    double value = std::stod(args[0]);
-
     // TODO: implement
     LOG_ERROR("Not implemented");
 }
 
-void plgLoadSaveSave(Engine& engine, std::vector<std::string> args)
+void plgLoadSaveSave(Engine& engine, double value)
 {
-    if (args.size() != 1) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    double value = std::stod(args[0]);
-
     // TODO: implement
     LOG_ERROR("Not implemented");
 }
 
-void plgMultiCdSetNextScript(Engine& engine, std::vector<std::string> args)
+void plgMultiCdSetNextScript(Engine& engine, const std::string& value)
 {
-    if (args.size() != 1) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    std::string value = args[0];
-
     // TODO: implement
     LOG_ERROR("Not implemented");
 }
@@ -694,21 +519,12 @@ void plgReset(Engine& engine, std::vector<std::string> args)
         g_louvreData.objectChest[i] = 0;
     }
     for (int i = 0; i < 13; ++i) {
-        engine.setStateValue("pos" + std::to_string(i), "0");
+        engine.setStateNumber("pos" + std::to_string(i), 0.0);
     }
 }
 
-void plgAddObject(Engine& engine, std::vector<std::string> args)
+void plgAddObject(Engine& engine, double value, const std::string& cond, const std::string& notCond)
 {
-    if (args.size() != 3) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    double value = std::stod(args[0]);
-    std::string cond = args[1];
-    std::string notCond = args[2];
-
     bool inserted = false;
     for (int i = 0; i < INVENTORY_SIZE; ++i) {
         if (g_louvreData.objectInventory[i] == -1) {
@@ -718,34 +534,18 @@ void plgAddObject(Engine& engine, std::vector<std::string> args)
         }
     }
 
-    engine.setStateValue(cond, inserted ? "1.0" : "0.0");
-    engine.setStateValue(notCond, inserted ? "0.0" : "1.0");
+    engine.setStateNumber(cond, inserted ? 1.0 : 0.0);
+    engine.setStateNumber(notCond, inserted ? 0.0 : 1.0);
 }
 
-void plgAddCoffreObject(Engine& engine, std::vector<std::string> args)
+void plgAddCoffreObject(Engine& engine, double value)
 {
-    if (args.size() != 1) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    double value = std::stod(args[0]);
-
     // TODO: implement
     LOG_ERROR("Not implemented");
 }
 
-void plgIsPresent(Engine& engine, std::vector<std::string> args)
+void plgIsPresent(Engine& engine, double value, const std::string& cond, const std::string& notCond)
 {
-    if (args.size() != 3) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    double value = std::stod(args[0]);
-    std::string cond = args[1];
-    std::string notCond = args[2];
-
     // TODO: implement correctly
     bool result = false;
     for (int i = 0; i < INVENTORY_SIZE; ++i) {
@@ -754,18 +554,12 @@ void plgIsPresent(Engine& engine, std::vector<std::string> args)
             break;
         }
     }
-    engine.setStateValue(cond, result ? "1.0" : "0.0");
-    engine.setStateValue(notCond, result ? "0.0" : "1.0");
+    engine.setStateNumber(cond, result ? 1.0 : 0.0);
+    engine.setStateNumber(notCond, result ? 0.0 : 1.0);
 }
 
-void plgRemoveObject(Engine& engine, std::vector<std::string> args)
+void plgRemoveObject(Engine& engine, double value)
 {
-    if (args.size() != 1) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    double value = std::stod(args[0]);
     for (int i = 0; i < INVENTORY_SIZE; ++i) {
         if (g_louvreData.objectInventory[i] == (int)value) {
             g_louvreData.objectInventory[i] = -1;
@@ -774,43 +568,20 @@ void plgRemoveObject(Engine& engine, std::vector<std::string> args)
     }
 }
 
-void plgStartTimer(Engine& engine, std::vector<std::string> args)
+void plgStartTimer(Engine& engine, double value)
 {
-    if (args.size() != 1) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    double value = std::stod(args[0]);
-
     // TODO: implement
     LOG_ERROR("Not implemented");
 }
 
-void plgLoadSaveTestSlot(Engine& engine, std::vector<std::string> args)
+void plgLoadSaveTestSlot(Engine& engine, double value, const std::string& cond, const std::string& notCond)
 {
-    if (args.size() != 3) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    double value = std::stod(args[0]);
-    std::string cond = args[1];
-    std::string notCond = args[2];
-
     // TODO: implement
     LOG_ERROR("Not implemented");
 }
 
-void plgLoadSaveLoad(Engine& engine, std::vector<std::string> args)
+void plgLoadSaveLoad(Engine& engine, double value)
 {
-    if (args.size() != 1) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    double value = std::stod(args[0]);
-
     // TODO: implement
     LOG_ERROR("Not implemented");
 }
@@ -821,31 +592,14 @@ void plgSaveCoffre(Engine& engine, std::vector<std::string> args)
     LOG_ERROR("Not implemented");
 }
 
-void plgLoadSaveSetContextLabel(Engine& engine, std::vector<std::string> args)
+void plgLoadSaveSetContextLabel(Engine& engine, const std::string& value)
 {
-    if (args.size() != 1) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    std::string value = args[0];
-
     // TODO: implement
     LOG_ERROR("Not implemented");
 }
 
-void plgLoadSaveDrawSlot(Engine& engine, std::vector<std::string> args)
+void plgLoadSaveDrawSlot(Engine& engine, double value1, double value2, double value3, double value4)
 {
-    if (args.size() != 4) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    double value1 = std::stod(args[0]);
-    double value2 = std::stod(args[1]);
-    double value3 = std::stod(args[2]);
-    double value4 = std::stod(args[3]);
-
     // TODO: implement
     LOG_ERROR("Not implemented");
 }
@@ -855,52 +609,30 @@ void plgEnd(Engine& engine, std::vector<std::string> args)
     engine.end();
 }
 
-void plgInit2(Engine& engine, std::vector<std::string> args)
+void plgInit2(Engine& engine, const std::string& variable)
 {
-    if (args.size() != 1) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    std::string variable = args[0];
-    engine.setStateValue(variable, "0.0");
+    engine.setStateNumber(variable, 0.0);
 }
 
-void plgInit(Engine& engine, std::vector<std::string> args)
+void plgInit(Engine& engine, double value, const std::string& variable)
 {
-    if (args.size() != 2) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    double value = std::stod(args[0]);
-    std::string variable = args[1];
-
     bool ret = g_louvreData.arnVit.open("data/bdataheader.vit", "data/bdata1.arn");
     if (!ret) {
         LOG_ERROR("Failed to open ARN/VIT");
         return;
     }
 
-    engine.setStateValue(variable, "0.0");
+    engine.setStateNumber(variable, 0.0);
     if (value == 2) {
-        engine.setStateValue(variable, "1.0");
+        engine.setStateNumber(variable, 1.0);
     }
 }
 
-void plgLoadSaveEnterScript(Engine& engine, std::vector<std::string> args)
+void plgLoadSaveEnterScript(Engine& engine, const std::string& var, const std::string& notVar)
 {
-    if (args.size() != 2) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    std::string var = args[0];
-    std::string notVar = args[1];
-
     // TODO: implement
-    engine.setStateValue(var, "0.0"); // Reloading
-    engine.setStateValue(notVar, "1.0"); // Not reloading
+    engine.setStateNumber(var, 0.0); // Reloading
+    engine.setStateNumber(notVar, 1.0); // Not reloading
 
     LOG_ERROR("Not implemented");
 }
@@ -911,17 +643,8 @@ void plgLoadCoffre(Engine& engine, std::vector<std::string> args)
     LOG_ERROR("Not implemented");
 }
 
-void plgSelect(Engine& engine, std::vector<std::string> args)
+void plgSelect(Engine& engine, double value, const std::string& w, const std::string& z)
 {
-    if (args.size() != 3) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    double value = std::stod(args[0]);
-    std::string w = args[1];
-    std::string z = args[2];
-
     int objectId = g_louvreData.objectInventory[(int)value - 1];
     if (objectId == -1) {
         LOG_ERROR("Invalid object id");
@@ -933,16 +656,8 @@ void plgSelect(Engine& engine, std::vector<std::string> args)
     printPortefSelectedObject(engine, g_louvreData.selectedObjectSlot);
 }
 
-void plgDoAction(Engine& engine, std::vector<std::string> args)
+void plgDoAction(Engine& engine, double value, const std::string& z)
 {
-    if (args.size() != 2) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    double value = std::stod(args[0]);
-    std::string z = args[1];
-
     switch ((int)value) {
     case 1: {
         // Take
@@ -953,7 +668,7 @@ void plgDoAction(Engine& engine, std::vector<std::string> args)
 
         int objectId = g_louvreData.objectInventory[g_louvreData.selectedObjectSlot];
         if (g_objectMap[objectId].canUse) {
-            engine.setStateValue("inventaire", std::to_string((double)objectId));
+            engine.setStateNumber("inventaire", objectId);
         } else {
             LOG_ERROR("Object cannot be used");
         }
@@ -977,15 +692,8 @@ void plgDoAction(Engine& engine, std::vector<std::string> args)
     }
 }
 
-void plgDiscocier(Engine& engine, std::vector<std::string> args)
+void plgDiscocier(Engine& engine, const std::string& z)
 {
-    if (args.size() != 1) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    std::string z = args[0];
-
     // TODO: implement
     LOG_ERROR("Not implemented");
 }
@@ -994,53 +702,53 @@ void registerPluginLouvre(Engine& engine)
 {
     LOG_INFO("Registering plugin");
 
-    engine.registerScriptPluginFunction("play_movie", &plgPlayMovie);
-    engine.registerScriptPluginFunction("cmp", &plgCmp);
+    engine.registerScriptPluginFunction<&plgPlayMovie>("play_movie");
+    engine.registerScriptPluginFunction<&plgCmp>("cmp");
     engine.registerScriptPluginFunction("killtimer", &plgKillTimer);
-    engine.registerScriptPluginFunction("cartedestination", &plgCarteDestination);
-    engine.registerScriptPluginFunction("pausetimer", &plgPauseTimer);
-    engine.registerScriptPluginFunction("add", &plgAdd);
+    engine.registerScriptPluginFunction<&plgCarteDestination>("cartedestination");
+    engine.registerScriptPluginFunction<&plgPauseTimer>("pausetimer");
+    engine.registerScriptPluginFunction<&plgAdd>("add");
     engine.registerScriptPluginFunction("initcoffre", &plgInitCoffre);
-    engine.registerScriptPluginFunction("afficheportef", &plgAffichePortef);
+    engine.registerScriptPluginFunction<&plgAffichePortef>("afficheportef");
     engine.registerScriptPluginFunction("afficheselection", &plgAfficheSelection);
     engine.registerScriptPluginFunction("affichecoffre", &plgAfficheCoffre);
-    engine.registerScriptPluginFunction("scroll", &plgScroll);
-    engine.registerScriptPluginFunction("selectportef", &plgSelectPorteF);
-    engine.registerScriptPluginFunction("play_animbloc", &plgPlayAnimBloc);
-    engine.registerScriptPluginFunction("until", &plgUntilLoop);
+    engine.registerScriptPluginFunction<&plgScroll>("scroll");
+    engine.registerScriptPluginFunction<&plgSelectPorteF>("selectportef");
+    engine.registerScriptPluginFunction<&plgPlayAnimBloc>("play_animbloc");
+    engine.registerScriptPluginFunction<&plgUntilLoop>("until");
     engine.registerScriptPluginFunction("memoryrelease", &plgMemoryRelease);
-    engine.registerScriptPluginFunction("selectcoffre", &plgSelectCoffre);
-    engine.registerScriptPluginFunction("play_animbloc_number", &plgPlayAnimBlocNumber);
-    engine.registerScriptPluginFunction("sub", &plgSub);
-    engine.registerScriptPluginFunction("while", &plgWhileLoop);
+    engine.registerScriptPluginFunction<&plgSelectCoffre>("selectcoffre");
+    engine.registerScriptPluginFunction<&plgPlayAnimBlocNumber>("play_animbloc_number");
+    engine.registerScriptPluginFunction<&plgSub>("sub");
+    engine.registerScriptPluginFunction<&plgWhileLoop>("while");
     engine.registerScriptPluginFunction("ishere", &plgIsHere);
     engine.registerScriptPluginFunction("drawtextselection", &plgDrawTextSelection);
-    engine.registerScriptPluginFunction("portefrollover", &plgPorteFRollover);
-    engine.registerScriptPluginFunction("setmonde4", &plgSetMonde4);
-    engine.registerScriptPluginFunction("getmonde4", &plgGetMonde4);
-    engine.registerScriptPluginFunction("changecurseur", &plgChangeCurseur);
-    engine.registerScriptPluginFunction("loadsave_context_restored", &plgLoadSaveContextRestored);
+    engine.registerScriptPluginFunction<&plgPorteFRollover>("portefrollover");
+    engine.registerScriptPluginFunction<&plgSetMonde4>("setmonde4");
+    engine.registerScriptPluginFunction<&plgGetMonde4>("getmonde4");
+    engine.registerScriptPluginFunction<&plgChangeCurseur>("changecurseur");
+    engine.registerScriptPluginFunction<&plgLoadSaveContextRestored>("loadsave_context_restored");
     engine.registerScriptPluginFunction("loadsave_capture_context", &plgLoadSaveCaptureContext);
-    engine.registerScriptPluginFunction("loadsave_init_slots", &plgLoadSaveInitSlots);
-    engine.registerScriptPluginFunction("loadsave_save", &plgLoadSaveSave);
-    engine.registerScriptPluginFunction("multicd_set_next_script", &plgMultiCdSetNextScript);
+    engine.registerScriptPluginFunction<&plgLoadSaveInitSlots>("loadsave_init_slots");
+    engine.registerScriptPluginFunction<&plgLoadSaveSave>("loadsave_save");
+    engine.registerScriptPluginFunction<&plgMultiCdSetNextScript>("multicd_set_next_script");
     engine.registerScriptPluginFunction("reset", &plgReset);
-    engine.registerScriptPluginFunction("addobject", &plgAddObject);
-    engine.registerScriptPluginFunction("addcoffreobject", &plgAddCoffreObject);
-    engine.registerScriptPluginFunction("ispresent", &plgIsPresent);
-    engine.registerScriptPluginFunction("removeobject", &plgRemoveObject);
-    engine.registerScriptPluginFunction("starttimer", &plgStartTimer);
-    engine.registerScriptPluginFunction("loadsave_test_slot", &plgLoadSaveTestSlot);
-    engine.registerScriptPluginFunction("loadsave_load", &plgLoadSaveLoad);
+    engine.registerScriptPluginFunction<&plgAddObject>("addobject");
+    engine.registerScriptPluginFunction<&plgAddCoffreObject>("addcoffreobject");
+    engine.registerScriptPluginFunction<&plgIsPresent>("ispresent");
+    engine.registerScriptPluginFunction<&plgRemoveObject>("removeobject");
+    engine.registerScriptPluginFunction<&plgStartTimer>("starttimer");
+    engine.registerScriptPluginFunction<&plgLoadSaveTestSlot>("loadsave_test_slot");
+    engine.registerScriptPluginFunction<&plgLoadSaveLoad>("loadsave_load");
     engine.registerScriptPluginFunction("savecoffre", &plgSaveCoffre);
-    engine.registerScriptPluginFunction("loadsave_set_context_label", &plgLoadSaveSetContextLabel);
-    engine.registerScriptPluginFunction("loadsave_draw_slot", &plgLoadSaveDrawSlot);
+    engine.registerScriptPluginFunction<&plgLoadSaveSetContextLabel>("loadsave_set_context_label");
+    engine.registerScriptPluginFunction<&plgLoadSaveDrawSlot>("loadsave_draw_slot");
     engine.registerScriptPluginFunction("end", &plgEnd);
-    engine.registerScriptPluginFunction("init2", &plgInit2);
-    engine.registerScriptPluginFunction("init", &plgInit);
-    engine.registerScriptPluginFunction("loadsave_enter_script", &plgLoadSaveEnterScript);
+    engine.registerScriptPluginFunction<&plgInit2>("init2");
+    engine.registerScriptPluginFunction<&plgInit>("init");
+    engine.registerScriptPluginFunction<&plgLoadSaveEnterScript>("loadsave_enter_script");
     engine.registerScriptPluginFunction("loadcoffre", &plgLoadCoffre);
-    engine.registerScriptPluginFunction("select", &plgSelect);
-    engine.registerScriptPluginFunction("doaction", &plgDoAction);
-    engine.registerScriptPluginFunction("discocier", &plgDiscocier);
+    engine.registerScriptPluginFunction<&plgSelect>("select");
+    engine.registerScriptPluginFunction<&plgDoAction>("doaction");
+    engine.registerScriptPluginFunction<&plgDiscocier>("discocier");
 }
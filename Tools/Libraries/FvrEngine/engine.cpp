@@ -1,11 +1,20 @@
 #include "engine.h"
 
 #include <algorithm>
+#include <charconv>
 #include <chrono>
+#include <cmath>
 #include <cstring>
+#include <deque>
 #include <filesystem>
+#include <fstream>
+#include <future>
 #include <iostream>
+#include <iterator>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <numbers>
 #include <set>
 #include <thread>
 
@@ -25,149 +34,110 @@ extern "C" {
 #include <ofnx/graphics/rendereropengl.h>
 #include <ofnx/tools/log.h>
 
+#include "engine/animationtimeline.h"
 #include "engine/audio.h"
+#include "engine/dirtyregion.h"
 #include "engine/eventmanager.h"
+#include "engine/prefetcher.h"
+#include "engine/scriptimage.h"
+#include "engine/scriptindex.h"
+#include "engine/scriptprofiler.h"
+#include "engine/scriptprogram.h"
+#include "engine/scriptscheduler.h"
+#include "engine/statevariables.h"
+#include "engine/threadpool.h"
+#include "engine/vranimationindex.h"
+#include "engine/warpcache.h"
 
 /* Constants */
 #define ENGINE_DATA_PATH "data/"
-#define ENGINE_FPS 30
+#define ENGINE_FPS 30 // Game logic tick rate
+#define ENGINE_MAX_TICKS 8 // Logic ticks run at once before dropping late ones
+#define RENDER_FPS_DEFAULT 60 // Panorama render rate when the display refresh rate is unknown
+#define RENDER_FPS_MAX 240
 #define ENGINE_WIDTH 640
 #define ENGINE_HEIGHT 480
+#define ENGINE_PANORAMA_WIDTH 256
 #define WINDOW_FOV 1.0f
 #define MOUSE_SENSITIVITY 0.1f
+#define CAMERA_MAX_INTERVAL_NS 100000000 // Input samples further apart are not interpolated
+#define SCRIPT_PROFILE_LINES 20 // Functions and blocks listed in the profile report
+#define ENGINE_IDLE_TIMEOUT_MS 250 // Longest input wait in render on demand mode, below ANIMATION_MAX_ELAPSED
+#define ANIMATION_MAX_ELAPSED 0.25 // Seconds, longer stalls do not fast-forward animations
+#define PANORAMA_FACE_COUNT 6
+#define PANORAMA_TILES_PER_FACE 4
+#define PANORAMA_FACE_TILES 0xfu // Tile mask of the first face
+#define PANORAMA_CULL_MARGIN 15.0f // Degrees
+#define WARP_CACHE_RAW_BUDGET (32 * 1024 * 1024)
+#define WARP_CACHE_DECODED_BUDGET (64 * 1024 * 1024)
+#define PREFETCH_QUEUE_SIZE 8
 
 /* Script functions */
-void fvrGotoWarp(Engine& engine, std::vector<std::string> args)
+void fvrGotoWarp(Engine& engine, const std::string& warpId)
 {
-    if (args.size() != 1) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    std::string warpId = args[0];
-
     engine.gotoWarp(warpId);
 }
 
-void fvrPlaySound(Engine& engine, std::vector<std::string> args)
+void fvrPlaySound(Engine& engine, std::string sound, double volume, double loop)
 {
-    if (args.size() != 3) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    std::string sound = args[0];
-    double volume = std::stod(args[1]);
-    double loop = std::stod(args[2]);
-
     // To lowercase
     std::transform(sound.begin(), sound.end(), sound.begin(), ::tolower);
 
     engine.playSound(sound, (int)volume, loop == -1);
 }
 
-void fvrStopSound(Engine& engine, std::vector<std::string> args)
+void fvrStopSound(Engine& engine, std::string sound)
 {
-    if (args.size() != 1) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    std::string sound = args[0];
-
     // To lowercase
     std::transform(sound.begin(), sound.end(), sound.begin(), ::tolower);
 
     engine.stopSound(sound);
 }
 
-void fvrPlaySound3d(Engine& engine, std::vector<std::string> args)
+void fvrPlaySound3d(Engine& engine, const std::string& sound, double x, double y, double z)
 {
-    if (args.size() != 4) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    std::string sound = args[0];
-    double x = std::stod(args[1]);
-    double y = std::stod(args[2]);
-    double z = std::stod(args[3]);
-
     // TODO: implement properly
     engine.playSound(sound, 100, false);
 }
 
-void fvrStopSound3d(Engine& engine, std::vector<std::string> args)
+void fvrStopSound3d(Engine& engine, const std::string& sound)
 {
-    if (args.size() != 1) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    std::string sound = args[0];
-
     // TODO: implement properly
     engine.stopSound(sound);
 }
 
-void fvrPlayMusic(Engine& engine, std::vector<std::string> args)
+void fvrPlayMusic(Engine& engine, const std::string& music)
 {
-    if (args.size() != 1) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    std::string music = args[0];
-
     // TODO: implement properly
     engine.playSound(music, 100, true);
 }
 
-void fvrStopMusic(Engine& engine, std::vector<std::string> args)
+void fvrStopMusic(Engine& engine, const std::string& music)
 {
-    if (args.size() != 1) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    std::string music = args[0];
-
     engine.stopSound(music);
 }
 
-void fvrSet(Engine& engine, std::vector<std::string> args)
+void fvrSet(Engine& engine, const std::string& flag, double value)
 {
-    if (args.size() != 2) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    std::string flag = args[0];
-    double value = std::stod(args[1]);
-
-    engine.setStateValue(flag, std::to_string(value));
+    engine.setStateNumber(flag, value);
 }
 
-void fvrLockKey(Engine& engine, std::vector<std::string> args)
+void fvrLockKey(Engine& engine, double key, const std::string& target)
 {
-    if (args.size() != 2) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
     /*
      * 0: Esc
      * 12: Right-click
      */
-    double key = std::stod(args[0]);
 
+    // Target is either 0 to unlock or a warp name
     // TODO: better way to handle this ?
-    try {
-        if (std::stod(args[1]) == 0) {
+    double value = 0.0;
+    if (scriptbinding::Parameter<double>::parse(target, value)) {
+        if (value == 0) {
             engine.unregisterKeyWarp((int)key);
         }
-    } catch (const std::exception&) {
-        std::string warp = args[1];
+    } else {
+        std::string warp = target;
         // Remove trailing '.vr' from warp name
         // warp = warp.substr(0, warp.size() - 3);
 
@@ -183,17 +153,8 @@ void fvrResetLockKey(Engine& engine, std::vector<std::string> args)
     engine.clearKeyWarps();
 }
 
-void fvrSetCursor(Engine& engine, std::vector<std::string> args)
+void fvrSetCursor(Engine& engine, std::string cursor, std::string warp, double zone)
 {
-    if (args.size() != 3) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    std::string cursor = args[0];
-    std::string warp = args[1];
-    double zone = std::stod(args[2]);
-
     // To lowercase
     std::transform(cursor.begin(), cursor.end(), cursor.begin(), ::tolower);
     std::transform(warp.begin(), warp.end(), warp.begin(), ::tolower);
@@ -201,30 +162,13 @@ void fvrSetCursor(Engine& engine, std::vector<std::string> args)
     engine.setWarpZoneCursor(warp, (int)zone, cursor);
 }
 
-void fvrSetCursorDefault(Engine& engine, std::vector<std::string> args)
+void fvrSetCursorDefault(Engine& engine, double value, const std::string& cursor)
 {
-    if (args.size() != 2) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    double value = std::stod(args[0]);
-    std::string cursor = args[1];
-
     engine.setDefaultCursor(value, cursor);
 }
 
-void fvrFade(Engine& engine, std::vector<std::string> args)
+void fvrFade(Engine& engine, double start, double end, double timer)
 {
-    if (args.size() != 3) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    double start = std::stod(args[0]);
-    double end = std::stod(args[1]);
-    double timer = std::stod(args[2]);
-
     engine.fade(start, end, timer);
 }
 
@@ -233,15 +177,10 @@ void fvrEnd(Engine& engine, std::vector<std::string> args)
     engine.end();
 }
 
-void fvrSetAngle(Engine& engine, std::vector<std::string> args)
+void fvrSetAngle(Engine& engine, int pitchAngle, int yawAngle)
 {
-    if (args.size() != 2) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    int pitchInt = (int)std::stod(args[0]) & 0x1fff;
-    int yawInt = (int)std::stod(args[1]) & 0x1fff;
+    int pitchInt = pitchAngle & 0x1fff;
+    int yawInt = yawAngle & 0x1fff;
 
     if (0xfff < (uint32_t)pitchInt) {
         pitchInt = pitchInt - 0x2000;
@@ -255,82 +194,38 @@ void fvrSetAngle(Engine& engine, std::vector<std::string> args)
     engine.setAngle(pitch, yaw);
 }
 
-void fvrHideCursor(Engine& engine, std::vector<std::string> args)
+void fvrHideCursor(Engine& engine, const std::string& value1, double value2)
 {
-    if (args.size() != 2) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    std::string value1 = args[0];
-    double value2 = std::stod(args[1]);
-
     // TODO: implement
     LOG_ERROR("Not implemented");
 }
 
-void fvrNot(Engine& engine, std::vector<std::string> args)
+void fvrNot(Engine& engine, const std::string& value)
 {
-    if (args.size() != 1) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    std::string value = args[0];
-    double val = std::stod(engine.getStateValue(value));
-    engine.setStateValue(value, val == 0.0 ? "1.0" : "0.0");
+    double val = engine.getStateNumber(value);
+    engine.setStateNumber(value, val == 0.0 ? 1.0 : 0.0);
 }
 
-void fvrAngleXMax(Engine& engine, std::vector<std::string> args)
+void fvrAngleXMax(Engine& engine, double value)
 {
-    if (args.size() != 1) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    double value = std::stod(args[0]);
-
     // TODO: implement
     LOG_ERROR("Not implemented");
 }
 
-void fvrAngleYMax(Engine& engine, std::vector<std::string> args)
+void fvrAngleYMax(Engine& engine, double value)
 {
-    if (args.size() != 1) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    double value = std::stod(args[0]);
-
     // TODO: implement
     LOG_ERROR("Not implemented");
 }
 
-void fvrSetZoom(Engine& engine, std::vector<std::string> args)
+void fvrSetZoom(Engine& engine, double value)
 {
-    if (args.size() != 1) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    double value = std::stod(args[0]);
-
     // TODO: implement
     LOG_ERROR("Not implemented");
 }
 
-void fvrInterpolAngle(Engine& engine, std::vector<std::string> args)
+void fvrInterpolAngle(Engine& engine, double value1, double value2, double value3)
 {
-    if (args.size() != 3) {
-        LOG_ERROR("Invalid number of arguments");
-        return;
-    }
-
-    double value1 = std::stod(args[0]);
-    double value2 = std::stod(args[1]);
-    double value3 = std::stod(args[2]);
-
     // TODO: implement
     LOG_ERROR("Not implemented");
 }
@@ -345,21 +240,91 @@ public:
         Pointer,
     };
 
-public:
-    bool loadScript(const std::string& scriptFile);
-    void registerScriptFunction(const std::string& name, const ScriptFunction& function);
+    struct ScriptAssets {
+        std::vector<std::string> warps; // Ordered by first appearance
+        std::set<std::string> sounds;
+        std::set<std::string> cursors;
+    };
 
-    void onWarpEnter(const std::string& warpName);
-    void onWarpZoneClick(const std::string& warpName, int zoneId);
+    // Warp assets loaded by workers
+    struct WarpLoad {
+        std::string warpName;
+        std::chrono::steady_clock::time_point start;
+        bool isStarted = false;
+        bool isFinished = false;
+        int warpId = -1; // Script index id once entered, -1 if the warp failed to load
+        std::weak_ptr<ScriptScheduler::Wait> enterWait; // Block running the init block in place once entered
+
+        std::unique_ptr<ofnx::files::Vr> fileVr = std::make_unique<ofnx::files::Vr>();
+        std::shared_ptr<WarpCache::DecodedWarp> loadedWarp; // Filled by workers on cache miss
+        WarpCache::DecodedPtr warp;
+        bool isCached = false;
+        bool isVrLoaded = false;
+        bool isVrDecoded = false;
+        bool isAnimationIndexed = false;
+
+        WarpStats stats;
+        std::chrono::steady_clock::time_point imageEnd;
+        std::chrono::steady_clock::time_point dataEnd;
+        std::future<void> imageTask;
+        std::future<void> dataTask;
+    };
 
-    void executeBlock(const ofnx::files::Lst::InstructionBlock& block);
-    void executeBlockPlugin(const ofnx::files::Lst::InstructionBlock& block);
+public:
+    bool loadScript(const std::string& scriptFile);
+    template <auto Function>
+    void registerScriptFunction(const std::string& name) { registerScriptFunction(name, makeScriptBinding<Function>()); }
+    void registerScriptFunction(const std::string& name, const ScriptFunction& function) { registerScriptFunction(name, makeScriptBinding(function)); }
+    void registerScriptFunction(const std::string& name, const ScriptBinding& binding);
+
+    void onWarpEnter(int warpId);
+    void onWarpZoneClick(int warpId, int zoneId);
+
+    void compileScript();
+    void indexScriptWarps(uint32_t first);
+    ofnx::files::Lst* textScript();
+    int resolveScriptFunction(const std::string& name, bool isPlugin, const std::vector<std::string>& params, ScriptProgram::Arguments& arguments);
+    uint32_t compileBlock(uint32_t block);
+    int indexWarp(const std::string& warpName);
+    int variableSlot(uint32_t stringId);
+    void logScriptProfile() const;
+    ScriptTask executeProgram(uint32_t entry);
+
+    WarpCache::RawPtr readWarpFile(const std::string& warpName);
+    std::shared_ptr<ofnx::files::Tst> loadZones(const std::string& warpName, int& zoneCount);
+    std::string zonesFile(const std::string& warpName) const;
+    int readZoneCount(const std::string& warpName) const;
+    void loadWarpImage(WarpLoad& load);
+    void loadWarpData(WarpLoad& load);
+
+    void updateTransition();
+    void startTransitionLoad();
+    void finishTransition();
+
+    static void collectScriptAssets(const ScriptImage& image, uint32_t block, ScriptAssets& assets);
+    void requestPrefetch();
+    void prefetchWarp(const std::string& warpName);
+
+    int checkZone(float x, float y);
 
     bool isPanoramic() const;
+    void markFrameBufferDirty();
+    void markFrameBufferDirty(int x, int y, int width, int height);
+    const uint16_t* fadedImageData();
+    uint32_t visiblePanoramaFaces() const;
+    void applyAnimationSteps(const std::string& animName, int lastStep, uint32_t visibleFaces);
+    void markInputTime(uint64_t timestampNs);
+    bool needsPresent() const;
+    int idleTimeoutMs() const;
+    void updateAnimations(double elapsedSeconds);
+    void addCameraSample(uint64_t timestampNs);
+    void resetCamera();
+    bool interpolateCamera(float& yaw, float& pitch) const;
     void render();
 
     void setCursorSettings(bool visible, bool centerLocked);
     void setCursorSystem(const CursorSystem& cursor);
+    SDL_Surface* loadCursorSurface(const std::string& cursorFile);
     void setCursor(const std::string& cursorFile);
 
 private:
@@ -367,15 +332,19 @@ private:
     bool m_isInit = false;
 
 #ifdef _WIN32
-    std::chrono::steady_clock::time_point m_lastTime;
+    std::chrono::steady_clock::time_point m_lastTime; // Last logic tick
+    std::chrono::steady_clock::time_point m_lastRenderTime;
 #else
-    std::chrono::_V2::system_clock::time_point m_lastTime;
+    std::chrono::_V2::system_clock::time_point m_lastTime; // Last logic tick
+    std::chrono::_V2::system_clock::time_point m_lastRenderTime;
 #endif
+    std::chrono::nanoseconds m_renderDelay; // Panorama frame period, follows the display refresh rate
 
     // Engine objects
     ofnx::graphics::RendererOpenGL m_rendererOgl;
     Audio m_audio;
     EventManager m_event;
+    ThreadPool m_threadPool;
 
     SDL_Window* m_window = nullptr;
     SDL_GLContext m_glContext;
@@ -383,23 +352,72 @@ private:
     CursorSystem m_cursorCurrent;
     SDL_Cursor* m_cursor = nullptr;
 
+    std::mutex m_cursorMutex;
+    std::map<std::string, SDL_Surface*> m_cursorSurfaces;
+
     // Data
-    ofnx::files::Lst m_script;
-    std::map<std::string, ScriptFunction> m_functions;
-    std::map<std::string, ScriptFunction> m_functionsPlugin;
+    ScriptImage m_scriptImage;
+    std::string m_scriptFile;
+    std::unique_ptr<ofnx::files::Lst> m_textScript; // Parsed on demand for warps missing from the image
+    bool m_isTextScriptFailed = false;
+    std::map<std::string, ScriptBinding> m_functions;
+    std::map<std::string, ScriptBinding> m_functionsPlugin;
+    ScriptProgram m_program;
+    ScriptIndex m_scriptIndex;
+    std::vector<ScriptBinding> m_functionSlots;
+    std::map<std::pair<bool, std::string>, int> m_functionSlotIds; // Plugin flag and name
+    ScriptStats m_scriptStats;
+    std::string m_compiledBlockName; // Warp block being compiled, for errors
+    ScriptProfiler m_profiler;
+    ScriptScheduler m_scripts;
+    std::chrono::steady_clock::time_point m_startTime; // Loop start
+    double m_startupMs = 0.0; // Loop start to the first presented frame
     std::string m_dataPath;
 
-    ofnx::files::Vr m_fileVr;
-    ofnx::files::Tst m_fileTst;
+    std::unique_ptr<ofnx::files::Vr> m_fileVr = std::make_unique<ofnx::files::Vr>();
+    std::shared_ptr<ofnx::files::Tst> m_fileTst;
+    int m_zoneCount = 0;
+    WarpCache m_warpCache;
+
+    // Neighbouring warps preloading
+    Prefetcher m_prefetcher;
+    std::mutex m_prefetchMutex;
+    std::map<std::string, ScriptAssets> m_prefetchAssets; // Sounds and cursors to preload per warp
 
     bool m_isRunning = true;
 
-    std::string m_currentWarp;
+    int m_currentWarpId = -1; // Script index id
+    std::deque<std::shared_ptr<WarpLoad>> m_transitions; // Pending warp changes in request order, the current warp keeps running meanwhile
+    std::shared_ptr<WarpLoad> m_requestedTransition; // Last requested, taken by the op following a gotowarp call
+    WarpStats m_warpStats;
 
-    std::map<std::string, std::string> m_stateValues;
+    StateVariables m_stateVariables;
+    std::vector<int> m_stringSlots; // Variable slot of each interned program string, -1 until resolved
 
     std::vector<uint16_t> m_vrImageData;
-    std::set<std::string> m_playingAnim;
+    std::vector<uint16_t> m_fadedImageData; // Uploaded instead of m_vrImageData while fading
+    bool m_isFading = false;
+    double m_fadeLevel = 0.0; // Added to each colour component
+    bool m_isPanoramic = false;
+    AnimationTimeline m_animationTimeline;
+    std::map<std::string, int> m_animationSteps; // Last step applied to the image per animation
+
+    std::shared_ptr<const VrAnimationIndex> m_vrAnimationIndex; // Null if the warp animations are not indexed
+
+    // Render on demand
+    bool m_isRenderOnDemand = false;
+    bool m_isViewChanged = true; // Camera or window changed since the last present
+    uint64_t m_presentCount = 0;
+    uint64_t m_skippedPresentCount = 0;
+
+    // Input latency
+    uint64_t m_inputTimeNs = 0; // Oldest input not presented yet, 0 if none
+    LatencyStats m_inputLatency;
+
+    // Texture upload tracking
+    DirtyRegion m_dirtyRegion; // m_vrImageData areas changed since last upload
+    size_t m_frameDirtyBytes = 0; // Bytes modified during the last rendered frame
+    size_t m_frameUploadBytes = 0; // Bytes uploaded during the last rendered frame
 
     std::map<int, std::string> m_keyWarp;
     std::map<int, std::string> m_defaultCursor; // TODO: better implementation
@@ -410,60 +428,327 @@ private:
     float m_pitch = 90.0f;
     float m_roll = 0.0f;
 
+    // Rendered camera follows input samples
+    struct CameraSample {
+        uint64_t timestampNs = 0;
+        float yaw = 270.0f;
+        float pitch = 90.0f;
+    };
+    CameraSample m_cameraPrevious;
+    CameraSample m_cameraLast;
+
     int m_pointedZone = -1;
 };
 
 bool Engine::EnginePrivate::loadScript(const std::string& scriptFile)
 {
-    if (!m_script.parseLst(scriptFile)) {
-        LOG_ERROR("Failed to parse script file: {}", scriptFile);
-        return false;
+    // Suspended blocks point into the previous script
+    m_scripts.cancel();
+    m_isFading = false;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    m_scriptFile = scriptFile;
+    m_textScript.reset();
+    m_isTextScriptFailed = false;
+
+    std::vector<std::string> warpNames;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(m_dataPath + "warp/", error)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".vr") {
+            warpNames.push_back(entry.path().filename().string());
+        }
+    }
+
+    const auto zoneCounter = [this](const std::string& warpName) {
+        return readZoneCount(warpName);
+    };
+
+    // Precompiled image unless the text script or the warps changed since it was built
+    const std::string imageFile = ScriptImage::imagePath(scriptFile);
+    const ScriptImage::Source source = ScriptImage::sourceOf(scriptFile, warpNames, zoneCounter);
+    bool isCached = m_scriptImage.open(imageFile);
+    if (isCached && source != ScriptImage::Source() && m_scriptImage.source() != source) {
+        LOG_INFO("Script image {} is out of date, parsing {}", imageFile, scriptFile);
+        isCached = false;
+    }
+
+    if (!isCached) {
+        ofnx::files::Lst* script = textScript();
+        if (!script) {
+            m_scriptImage.close();
+            return false;
+        }
+
+        if (!m_scriptImage.load(ScriptImage::build(*script, warpNames, zoneCounter, source))) {
+            LOG_ERROR("Failed to build script image: {}", scriptFile);
+            return false;
+        }
     }
 
+    const double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("Loaded script {} in {:.2f} ms ({} bytes)", isCached ? imageFile : scriptFile, loadMs, m_scriptImage.byteSize());
+
     // Init state values
-    m_stateValues.clear();
-    for (const std::string& variable : m_script.getVariables()) {
-        parent->setStateValue(variable, "0");
+    m_stateVariables.clear();
+    for (uint32_t i = 0; i < m_scriptImage.variableCount(); i++) {
+        m_stateVariables.slot(std::string(m_scriptImage.string(m_scriptImage.variable(i))));
     }
 
+    compileScript();
+
+    m_scriptStats.isCached = isCached;
+    m_scriptStats.loadMs = loadMs;
+
     return true;
 }
 
-void Engine::EnginePrivate::registerScriptFunction(const std::string& name, const ScriptFunction& function)
+void Engine::EnginePrivate::compileScript()
+{
+    const auto start = std::chrono::steady_clock::now();
+    const std::string currentWarp = m_currentWarpId >= 0 ? m_scriptIndex.warpName(m_currentWarpId) : "";
+
+    m_program.clear();
+    m_scriptIndex.clear();
+    m_stringSlots.clear();
+    m_functionSlots.clear();
+    m_functionSlotIds.clear();
+    m_scriptStats = {};
+    m_profiler.clear();
+
+    indexScriptWarps(0);
+
+    // Ids do not survive a reload
+    if (!currentWarp.empty()) {
+        m_currentWarpId = indexWarp(currentWarp);
+    }
+
+    m_scriptStats.compileMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("Compiled {} script blocks of {} warps to {} ops, {} strings, {} bytes in {:.2f} ms, {} calls rejected",
+        m_program.blockCount(),
+        m_scriptIndex.warpCount(),
+        m_program.opCount(),
+        m_program.stringCount(),
+        m_program.byteSize(),
+        m_scriptStats.compileMs,
+        m_program.rejectedCount());
+}
+
+void Engine::EnginePrivate::indexScriptWarps(uint32_t first)
+{
+    // Blocks of every warp in the script image from the given one
+    for (uint32_t i = first; i < m_scriptImage.warpCount(); i++) {
+        const ScriptImage::Warp& warp = m_scriptImage.warp(i);
+        const std::string warpName(m_scriptImage.string(warp.name));
+
+        std::vector<ScriptIndex::Block> zoneBlocks(warp.zoneCount);
+        for (uint32_t zone = 0; zone < warp.zoneCount; zone++) {
+            const uint32_t block = m_scriptImage.zoneBlock(warp.firstZone + zone);
+            m_compiledBlockName = warpName + " zone " + std::to_string(zone);
+            zoneBlocks[zone] = { block, compileBlock(block) };
+        }
+
+        m_compiledBlockName = warpName + " init";
+        m_scriptIndex.addWarp(warpName, { warp.initBlock, compileBlock(warp.initBlock) }, zoneBlocks);
+    }
+    m_compiledBlockName.clear();
+}
+
+ofnx::files::Lst* Engine::EnginePrivate::textScript()
+{
+    // Parsed once, and only if the script image is missing something
+    if (!m_textScript && !m_isTextScriptFailed) {
+        std::unique_ptr<ofnx::files::Lst> script = std::make_unique<ofnx::files::Lst>();
+        if (script->parseLst(m_scriptFile)) {
+            m_textScript = std::move(script);
+        } else {
+            LOG_ERROR("Failed to parse script file: {}", m_scriptFile);
+            m_isTextScriptFailed = true;
+        }
+    }
+
+    return m_textScript.get();
+}
+
+int Engine::EnginePrivate::resolveScriptFunction(const std::string& name, bool isPlugin, const std::vector<std::string>& params, ScriptProgram::Arguments& arguments)
+{
+    const std::map<std::string, ScriptBinding>& functions = isPlugin ? m_functionsPlugin : m_functions;
+    auto function = functions.find(name);
+    if (function == functions.end()) {
+        if (isPlugin) {
+            LOG_ERROR("Script plugin function not found: {} (in {})", name, m_compiledBlockName);
+        } else {
+            LOG_ERROR("Script function not found: {} (in {})", name, m_compiledBlockName);
+        }
+        return -1;
+    }
+
+    std::string error;
+    arguments = function->second.bind(params, error);
+    if (!arguments) {
+        LOG_ERROR("Invalid call to script function {} (in {}): {}", name, m_compiledBlockName, error);
+        return -1;
+    }
+
+    auto slot = m_functionSlotIds.find({ isPlugin, name });
+    if (slot != m_functionSlotIds.end()) {
+        return slot->second;
+    }
+
+    const int slotId = (int)m_functionSlots.size();
+    m_functionSlots.push_back(function->second);
+    m_functionSlotIds[{ isPlugin, name }] = slotId;
+
+    return slotId;
+}
+
+uint32_t Engine::EnginePrivate::compileBlock(uint32_t block)
+{
+    return m_program.compile(m_scriptImage, block, [this](const std::string& name, bool isPlugin, const std::vector<std::string>& params, ScriptProgram::Arguments& arguments) {
+        return resolveScriptFunction(name, isPlugin, params, arguments);
+    });
+}
+
+void Engine::EnginePrivate::registerScriptFunction(const std::string& name, const ScriptBinding& binding)
 {
     if (m_functions.find(name) != m_functions.end()) {
         LOG_ERROR("Script function already registered: {}", name);
         return;
     }
 
-    m_functions[name] = function;
+    m_functions[name] = binding;
 }
 
-void Engine::EnginePrivate::onWarpEnter(const std::string& warpName)
+int Engine::EnginePrivate::indexWarp(const std::string& warpName)
 {
-    const ofnx::files::Lst::InstructionBlock& block = m_script.getInitBlock(warpName);
-    executeBlock(block);
+    const int id = m_scriptIndex.findWarp(warpName);
+    if (id >= 0) {
+        return id;
+    }
+
+    // Not in the script image, appended from the text script, compiled blocks keep their ids
+    ofnx::files::Lst* script = textScript();
+    if (script) {
+        const uint32_t first = m_scriptImage.warpCount();
+        const auto zoneCounter = [this](const std::string& name) {
+            return readZoneCount(name);
+        };
+        std::vector<uint8_t> data = ScriptImage::extend(*script, m_scriptImage, warpName, zoneCounter);
+        if (!data.empty()) {
+            ScriptImage extended;
+            if (extended.load(std::move(data))) {
+                m_scriptImage.swap(extended);
+                indexScriptWarps(first);
+                LOG_INFO("Warp {} is not in the script image, added {} warps from {}", warpName, m_scriptImage.warpCount() - first, m_scriptFile);
+            } else {
+                LOG_ERROR("Failed to extend script image with warp: {}", warpName);
+            }
+
+            const int addedId = m_scriptIndex.findWarp(warpName);
+            if (addedId >= 0) {
+                return addedId;
+            }
+        }
+    }
+
+    // Not in the text script either, the warp has no script
+    const ScriptIndex::Block emptyBlock = { ScriptImage::EmptyBlock, compileBlock(ScriptImage::EmptyBlock) };
+    std::vector<ScriptIndex::Block> zoneBlocks(readZoneCount(warpName), emptyBlock);
+
+    return m_scriptIndex.addWarp(warpName, emptyBlock, zoneBlocks);
+}
+
+void Engine::EnginePrivate::onWarpEnter(int warpId)
+{
+    m_scripts.run(executeProgram(m_scriptIndex.initBlock(warpId).entry));
 }
 
-void Engine::EnginePrivate::onWarpZoneClick(const std::string& warpName, int zoneId)
+void Engine::EnginePrivate::onWarpZoneClick(int warpId, int zoneId)
 {
-    const ofnx::files::Lst::InstructionBlock& block = m_script.getTestBlock(warpName, zoneId);
-    executeBlock(block);
+    const ScriptIndex::Block* block = m_scriptIndex.zoneBlock(warpId, zoneId);
+    if (!block) {
+        LOG_ERROR("Zone {} is not indexed for warp {}", zoneId, m_scriptIndex.warpName(warpId));
+        return;
+    }
+
+    m_scripts.run(executeProgram(block->entry));
 }
 
-void Engine::EnginePrivate::executeBlock(const ofnx::files::Lst::InstructionBlock& block)
+int Engine::EnginePrivate::variableSlot(uint32_t stringId)
 {
+    if (stringId >= m_stringSlots.size()) {
+        m_stringSlots.resize(m_program.stringCount(), -1);
+    }
+
+    int& slot = m_stringSlots[stringId];
+    if (slot < 0) {
+        slot = m_stateVariables.slot(m_program.string(stringId));
+    }
+
+    return slot;
+}
+
+ScriptTask Engine::EnginePrivate::executeProgram(uint32_t entry)
+{
+    using Opcode = ScriptProgram::Opcode;
+
+    // Ops are read by index, blocks compiled while this one waits may grow the program
+    uint32_t pc = entry;
+    auto sliceStart = std::chrono::steady_clock::now();
+    uint64_t calleeNs = 0; // Spent in functions during the slice, when profiling
+    const auto endSlice = [this, entry, &sliceStart, &calleeNs]() {
+        const std::chrono::nanoseconds slice = std::chrono::steady_clock::now() - sliceStart;
+        m_scriptStats.executionMs += std::chrono::duration<double, std::milli>(slice).count();
+        if (m_profiler.isEnabled()) {
+            m_profiler.addBlockTime(entry, (uint64_t)slice.count(), calleeNs);
+        }
+        calleeNs = 0;
+    };
+
+    if (m_profiler.isEnabled()) {
+        m_profiler.addBlockRun(entry);
+    }
+
     try {
-        for (const ofnx::files::Lst::Instruction& instruction : block) {
-            if (instruction.name == "plugin") {
-                executeBlockPlugin(instruction.subInstructions);
-            } else if (instruction.name == "ifand" || instruction.name == "ifor") {
+        while (true) {
+            const ScriptProgram::Op op = m_program.op(pc++);
+            m_scriptStats.instructionCount++;
+
+            if (op.opcode == Opcode::Return) {
+                break;
+            }
+
+            switch (op.opcode) {
+            case Opcode::Call:
+            case Opcode::CallPlugin:
+                if (m_profiler.isEnabled()) {
+                    const auto callStart = std::chrono::steady_clock::now();
+                    m_functionSlots[op.slot].call(*parent, m_program.arguments(op.arguments));
+                    const uint64_t callNs = (uint64_t)std::chrono::nanoseconds(std::chrono::steady_clock::now() - callStart).count();
+                    m_profiler.addCall(op.slot, entry, pc - 1 - entry, callNs);
+                    calleeNs += callNs;
+                } else {
+                    m_functionSlots[op.slot].call(*parent, m_program.arguments(op.arguments));
+                }
+
+                // Suspended until the main loop ends the wait this function requested
+                {
+                    ScriptScheduler::WaitAwaiter wait = m_scripts.takeRequest();
+                    if (!wait.await_ready()) {
+                        endSlice();
+                        co_await wait;
+                        sliceStart = std::chrono::steady_clock::now();
+                    }
+                }
+                break;
+            case Opcode::IfAnd:
+            case Opcode::IfOr: {
                 // Check parameters
-                bool exec = instruction.name == "ifand";
-                for (const std::string& param : instruction.params) {
-                    double value = std::stod(parent->getStateValue(param));
+                bool exec = op.opcode == Opcode::IfAnd;
+                for (uint32_t i = 0; i < op.count; i++) {
+                    double value = m_stateVariables.get(variableSlot(m_program.operand(op.first + i)));
 
-                    if (instruction.name == "ifand") {
+                    if (op.opcode == Opcode::IfAnd) {
                         if (value == 0.0) {
                             exec = false;
                             break;
@@ -476,75 +761,767 @@ void Engine::EnginePrivate::executeBlock(const ofnx::files::Lst::InstructionBloc
                     }
                 }
 
-                if (exec) {
-                    executeBlock(instruction.subInstructions);
+                if (!exec) {
+                    pc = op.target;
                 }
-            } else if (instruction.name == "return") {
-                return;
-            } else if (instruction.name == "end") {
+                break;
+            }
+            case Opcode::Jump:
+                pc = op.target;
+                break;
+            case Opcode::End:
                 parent->end();
-            } else {
-                if (m_functions.find(instruction.name) == m_functions.end()) {
-                    LOG_ERROR("Script function not found: {}", instruction.name);
-                    continue;
+                break;
+            case Opcode::EnterWarp: {
+                // As if the warp was entered during the call, its init block runs before the rest of this one
+                std::shared_ptr<WarpLoad> load = std::exchange(m_requestedTransition, nullptr);
+                if (!load) {
+                    break;
+                }
+
+                m_scripts.request([load](double) { return load->isFinished; }, nullptr, false);
+                ScriptScheduler::WaitAwaiter wait = m_scripts.takeRequest();
+                load->enterWait = wait.wait;
+                endSlice();
+                co_await wait;
+
+                if (load->warpId >= 0) {
+                    co_await executeProgram(m_scriptIndex.initBlock(load->warpId).entry);
                 }
+                sliceStart = std::chrono::steady_clock::now();
+                break;
+            }
+            default:
+                break;
+            }
+        }
+    } catch (const std::exception& e) {
+        LOG_ERROR("Error during script execution");
+        m_isRunning = false;
+    }
+
+    endSlice();
+}
+
+void Engine::EnginePrivate::logScriptProfile() const
+{
+    const auto ms = [](uint64_t ns) {
+        return ns / 1000000.0;
+    };
+
+    // Names are only looked up for the report
+    std::map<uint32_t, std::string> functionNames;
+    for (const auto& slot : m_functionSlotIds) {
+        functionNames[(uint32_t)slot.second] = (slot.first.first ? "plugin " : "") + slot.first.second;
+    }
+    std::map<uint32_t, std::string> blockNames;
+    for (int warp = 0; warp < (int)m_scriptIndex.warpCount(); warp++) {
+        const std::string& warpName = m_scriptIndex.warpName(warp);
+        blockNames.try_emplace(m_scriptIndex.initBlock(warp).entry, warpName + " init");
+        for (int zone = 0; zone < m_scriptIndex.zoneCount(warp); zone++) {
+            blockNames.try_emplace(m_scriptIndex.zoneBlock(warp, zone)->entry, warpName + " zone " + std::to_string(zone));
+        }
+    }
+
+    const std::vector<ScriptProfiler::Entry> functions = m_profiler.functions();
+    LOG_INFO("Script functions by time (calls, inclusive ms, exclusive ms):");
+    for (size_t i = 0; i < functions.size() && i < SCRIPT_PROFILE_LINES; i++) {
+        const ScriptProfiler::Entry& entry = functions[i];
+        LOG_INFO("  {:<24} {:>8} {:>10.2f} {:>10.2f}", functionNames[entry.id], entry.count, ms(entry.inclusiveNs), ms(entry.exclusiveNs));
+    }
+
+    const std::vector<ScriptProfiler::Entry> blocks = m_profiler.blocks();
+    LOG_INFO("Script blocks by time (runs, inclusive ms, exclusive ms):");
+    for (size_t i = 0; i < blocks.size() && i < SCRIPT_PROFILE_LINES; i++) {
+        const ScriptProfiler::Entry& entry = blocks[i];
+        LOG_INFO("  {:<24} {:>8} {:>10.2f} {:>10.2f}", blockNames[entry.id], entry.count, ms(entry.inclusiveNs), ms(entry.exclusiveNs));
+    }
+
+    LOG_INFO("Slowest script calls (ms):");
+    for (const ScriptProfiler::Sample& sample : m_profiler.slowest()) {
+        LOG_INFO("  {:>10.3f} {} in {} at op {}", ms(sample.ns), functionNames[sample.function], blockNames[sample.block], sample.op);
+    }
+}
+
+WarpCache::RawPtr Engine::EnginePrivate::readWarpFile(const std::string& warpName)
+{
+    WarpCache::RawPtr data = m_warpCache.getRaw(warpName);
+    if (data) {
+        return data;
+    }
+
+    std::ifstream file(m_dataPath + "warp/" + warpName, std::ios::binary);
+    if (!file.is_open()) {
+        return nullptr;
+    }
+
+    data = std::make_shared<std::vector<uint8_t>>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    m_warpCache.putRaw(warpName, data);
+
+    return data;
+}
+
+std::shared_ptr<ofnx::files::Tst> Engine::EnginePrivate::loadZones(const std::string& warpName, int& zoneCount)
+{
+    zoneCount = 0;
+    const std::string tstFile = zonesFile(warpName);
+
+    std::shared_ptr<ofnx::files::Tst> zones = std::make_shared<ofnx::files::Tst>();
+    if (!zones->loadFile(tstFile)) {
+        return nullptr;
+    }
+
+    zoneCount = readZoneCount(warpName);
+
+    return zones;
+}
+
+std::string Engine::EnginePrivate::zonesFile(const std::string& warpName) const
+{
+    // Remove '.vr' if it exists
+    std::string tstName = warpName;
+    if (tstName.find(".vr") != std::string::npos) {
+        tstName = tstName.substr(0, tstName.find(".vr"));
+    }
+
+    return m_dataPath + "tst/" + tstName + ".tst";
+}
+
+int Engine::EnginePrivate::readZoneCount(const std::string& warpName) const
+{
+    // Zone count is the first field of the file
+    uint32_t count = 0;
+    std::ifstream file(zonesFile(warpName), std::ios::binary);
+    if (!file.read(reinterpret_cast<char*>(&count), sizeof(count))) {
+        return 0;
+    }
+
+    return (int)count;
+}
+
+void Engine::EnginePrivate::loadWarpImage(WarpLoad& load)
+{
+    using Clock = std::chrono::steady_clock;
+    const auto msSince = [](Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+
+    Clock::time_point phaseStart = Clock::now();
+    load.isVrLoaded = load.fileVr->load(m_dataPath + "warp/" + load.warpName);
+    load.stats.loadMs = msSince(phaseStart);
+
+    phaseStart = Clock::now();
+    load.isVrDecoded = load.isVrLoaded && load.fileVr->getDataRgb565(load.loadedWarp->image);
+    load.stats.decodeMs = msSince(phaseStart);
+
+    if (load.isVrDecoded) {
+        WarpCache::DecodedWarp& warp = *load.loadedWarp;
+        warp.isPanoramic = load.fileVr->getType() == ofnx::files::Vr::Type::VR_STATIC_VR;
+
+        // Animation frames are decoded once, playback only copies blocks
+        phaseStart = Clock::now();
+        WarpCache::RawPtr data = readWarpFile(load.warpName);
+        auto animationIndex = std::make_shared<VrAnimationIndex>();
+        load.isAnimationIndexed = data && animationIndex->load(*data);
+        if (load.isAnimationIndexed) {
+            if (!animationIndex->animations().empty()) {
+                animationIndex->decodeFrames(*load.fileVr, warp.image, warp.isPanoramic ? ENGINE_PANORAMA_WIDTH : ENGINE_WIDTH);
+            }
+            warp.animationIndex = std::move(animationIndex);
+        }
+        load.stats.animationDecodeMs = msSince(phaseStart);
+    }
+
+    load.imageEnd = Clock::now();
+}
+
+void Engine::EnginePrivate::loadWarpData(WarpLoad& load)
+{
+    load.loadedWarp->zones = loadZones(load.warpName, load.loadedWarp->zoneCount);
+
+    load.dataEnd = std::chrono::steady_clock::now();
+}
+
+void Engine::EnginePrivate::updateTransition()
+{
+    if (m_transitions.empty()) {
+        return;
+    }
+
+    const std::shared_ptr<WarpLoad>& load = m_transitions.front();
+    if (!load->isStarted) {
+        // A prefetch of this warp is running, its result will land in the cache
+        if (!m_prefetcher.claim(load->warpName)) {
+            return;
+        }
+
+        startTransitionLoad();
+    }
+
+    const auto isDone = [](const std::future<void>& task) {
+        return !task.valid() || task.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    };
+
+    if (isDone(load->imageTask) && isDone(load->dataTask)) {
+        finishTransition();
+    }
+}
+
+void Engine::EnginePrivate::startTransitionLoad()
+{
+    // Tasks own the load so pending transitions can be dropped at any time
+    std::shared_ptr<WarpLoad> load = m_transitions.front();
+    load->isStarted = true;
+    load->stats.waitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - load->start).count();
+    load->imageEnd = load->dataEnd = std::chrono::steady_clock::now();
+
+    load->warp = m_warpCache.getDecoded(load->warpName);
+    load->isCached = load->warp != nullptr;
+    if (load->isCached) {
+        // VR file is only needed to play animations that could not be indexed or decoded
+        const VrAnimationIndex* animationIndex = load->warp->animationIndex.get();
+        if (!animationIndex || (!animationIndex->animations().empty() && !animationIndex->isDecoded())) {
+            load->imageTask = m_threadPool.submit([this, load]() {
+                const auto phaseStart = std::chrono::steady_clock::now();
+                load->isVrLoaded = load->fileVr->load(m_dataPath + "warp/" + load->warpName);
+                load->imageEnd = std::chrono::steady_clock::now();
+                load->stats.loadMs = std::chrono::duration<double, std::milli>(load->imageEnd - phaseStart).count();
+            });
+        }
+        return;
+    }
+
+    // Zones are read while the image is decoded
+    load->loadedWarp = std::make_shared<WarpCache::DecodedWarp>();
+    load->warp = load->loadedWarp;
+    load->imageTask = m_threadPool.submit([this, load]() { loadWarpImage(*load); });
+    load->dataTask = m_threadPool.submit([this, load]() { loadWarpData(*load); });
+}
+
+void Engine::EnginePrivate::finishTransition()
+{
+    using Clock = std::chrono::steady_clock;
+    const auto msSince = [](Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+
+    std::shared_ptr<WarpLoad> load = std::move(m_transitions.front());
+    m_transitions.pop_front();
+    load->isFinished = true;
+    load->stats.readyMs = std::chrono::duration<double, std::milli>(std::max(load->imageEnd, load->dataEnd) - load->start).count();
+
+    if (!load->isCached) {
+        if (load->isVrLoaded && !load->isVrDecoded) {
+            LOG_ERROR("Failed to load VR image data");
+            return;
+        }
+
+        if (load->isVrDecoded) {
+            if (!load->isAnimationIndexed) {
+                LOG_ERROR("Failed to index VR animations: {}", load->warpName);
+            }
+
+            m_warpCache.putDecoded(load->warpName, load->warp);
+        }
+    }
+
+    // Swap to the new warp at once
+    m_animationTimeline.clear();
+    m_animationSteps.clear();
+    m_currentWarpId = indexWarp(load->warpName);
+    load->warpId = m_currentWarpId;
+    m_warpZoneCursor.clear();
+    m_fileVr = std::move(load->fileVr);
+    m_fileTst = load->warp->zones;
+    m_zoneCount = load->warp->zoneCount;
+
+    if (load->isCached || load->isVrDecoded) {
+        m_vrImageData = load->warp->image;
+        m_isPanoramic = load->warp->isPanoramic;
+        m_vrAnimationIndex = load->warp->animationIndex; // Shared with the cache entry
+
+        const int width = isPanoramic() ? ENGINE_PANORAMA_WIDTH : ENGINE_WIDTH;
+        m_dirtyRegion.setBounds(width, (int)m_vrImageData.size() / width);
+        markFrameBufferDirty();
+        resetCamera();
+        m_isViewChanged = true;
+
+        if (isPanoramic()) {
+            setCursorSettings(true, true);
+        } else {
+            setCursorSettings(true, false);
+        }
+    } else {
+        // Warp without image
+        m_vrAnimationIndex.reset();
+        m_isPanoramic = false;
+    }
+
+    m_warpStats = load->stats;
+    m_warpStats.animationBytes = m_vrAnimationIndex ? m_vrAnimationIndex->byteSize() : 0;
+    m_warpStats.totalMs = msSince(load->start);
+    LOG_INFO("Warp {} ready in {:.2f} ms{} (load {:.2f} ms, decode {:.2f} ms, animations {:.2f} ms, wait {:.2f} ms), entered in {:.2f} ms",
+        load->warpName,
+        m_warpStats.readyMs,
+        load->isCached ? " from cache" : "",
+        m_warpStats.loadMs,
+        m_warpStats.decodeMs,
+        m_warpStats.animationDecodeMs,
+        m_warpStats.waitMs,
+        m_warpStats.totalMs);
+    if (m_warpStats.animationBytes > 0) {
+        LOG_INFO("Warp {} animations use {} bytes{}",
+            load->warpName,
+            m_warpStats.animationBytes,
+            m_vrAnimationIndex->isDecoded() ? " (decoded)" : "");
+    }
+
+    // Blocks still waiting belong to the warp that was left, unless waiting for a warp to be entered
+    m_scripts.cancelSkippable();
+    m_isFading = false;
+
+    requestPrefetch();
+    if (load->enterWait.expired()) {
+        onWarpEnter(m_currentWarpId);
+    }
+}
+
+void Engine::EnginePrivate::collectScriptAssets(const ScriptImage& image, uint32_t block, ScriptAssets& assets)
+{
+    const auto addWarp = [&assets](const std::string& warpName) {
+        if (std::find(assets.warps.begin(), assets.warps.end(), warpName) == assets.warps.end()) {
+            assets.warps.push_back(warpName);
+        }
+    };
+
+    const auto toLower = [](std::string value) {
+        std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+        return value;
+    };
+
+    // Arguments are transformed the same way the script functions do
+    const ScriptImage::Block& instructions = image.block(block);
+    for (uint32_t i = 0; i < instructions.instructionCount; i++) {
+        const ScriptImage::Instruction& instruction = image.instruction(instructions.firstInstruction + i);
+        const std::string_view name = image.string(instruction.name);
+        const std::vector<std::string> params = image.params(instruction);
+
+        if (name == "ifand" || name == "ifor") {
+            // Conditions are not evaluated, any branch may be taken
+            collectScriptAssets(image, instruction.block, assets);
+        } else if (name == "gotowarp" && params.size() == 1) {
+            addWarp(params[0]);
+        } else if (name == "lockkey" && params.size() == 2) {
+            // Numeric target unregisters the key
+            double value = 0.0;
+            if (!scriptbinding::Parameter<double>::parse(params[1], value)) {
+                addWarp(toLower(params[1]));
+            }
+        } else if (name == "playsound" && params.size() == 3) {
+            assets.sounds.insert(toLower(params[0]));
+        } else if ((name == "playsound3d" && params.size() == 4) || (name == "playmusique" && params.size() == 1)) {
+            assets.sounds.insert(params[0]);
+        } else if (name == "setcursor" && params.size() == 3) {
+            assets.cursors.insert(toLower(params[0]));
+        } else if (name == "setcursordefault" && params.size() == 2) {
+            assets.cursors.insert(params[1]);
+        }
+    }
+}
+
+void Engine::EnginePrivate::requestPrefetch()
+{
+    if (!m_prefetcher.isEnabled()) {
+        return;
+    }
+
+    const std::string& currentWarp = m_scriptIndex.warpName(m_currentWarpId);
+
+    try {
+        // Edges of the script graph: warps reachable from the current one
+        ScriptAssets assets;
+        collectScriptAssets(m_scriptImage, m_scriptIndex.initBlock(m_currentWarpId).block, assets);
+        for (int zone = 0; zone < m_scriptIndex.zoneCount(m_currentWarpId); zone++) {
+            collectScriptAssets(m_scriptImage, m_scriptIndex.zoneBlock(m_currentWarpId, zone)->block, assets);
+        }
+        for (const auto& keyWarp : m_keyWarp) {
+            if (std::find(assets.warps.begin(), assets.warps.end(), keyWarp.second) == assets.warps.end()) {
+                assets.warps.push_back(keyWarp.second);
+            }
+        }
+        std::erase(assets.warps, currentWarp);
+
+        // Current warp sounds and cursors are needed on click, neighbours ones on entry
+        std::map<std::string, ScriptAssets> prefetchAssets;
+        std::vector<std::string> warps = { currentWarp };
+        prefetchAssets[currentWarp] = { {}, assets.sounds, assets.cursors };
+        for (const std::string& warp : assets.warps) {
+            collectScriptAssets(m_scriptImage, m_scriptIndex.initBlock(indexWarp(warp)).block, prefetchAssets[warp]);
+            warps.push_back(warp);
+        }
+
+        std::set<std::string> sounds;
+        for (const auto& warpAssets : prefetchAssets) {
+            sounds.insert(warpAssets.second.sounds.begin(), warpAssets.second.sounds.end());
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_prefetchMutex);
+            m_prefetchAssets = std::move(prefetchAssets);
+        }
+
+        // Drop what became unreachable
+        m_audio.releasePreloadedSounds(sounds);
+        m_prefetcher.request(warps);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Failed to prefetch warps from {}: {}", currentWarp, e.what());
+    }
+}
+
+void Engine::EnginePrivate::prefetchWarp(const std::string& warpName)
+{
+    // Runs on a worker
+    if (!m_warpCache.containsDecoded(warpName)) {
+        WarpLoad load;
+        load.warpName = warpName;
+        load.loadedWarp = std::make_shared<WarpCache::DecodedWarp>();
+
+        loadWarpImage(load);
+        if (load.isVrDecoded) {
+            loadWarpData(load);
+            m_warpCache.putDecoded(warpName, load.loadedWarp);
+        }
+    }
+
+    ScriptAssets assets;
+    {
+        std::lock_guard<std::mutex> lock(m_prefetchMutex);
+        if (m_prefetchAssets.contains(warpName)) {
+            assets = m_prefetchAssets[warpName];
+        }
+    }
+
+    for (const std::string& sound : assets.sounds) {
+        m_audio.preloadSound(sound);
+    }
+
+    for (const std::string& cursor : assets.cursors) {
+        loadCursorSurface(ENGINE_DATA_PATH "image/" + cursor);
+    }
+}
+
+int Engine::EnginePrivate::checkZone(float x, float y)
+{
+    if (!m_fileTst) {
+        return -1;
+    }
+
+    if (isPanoramic()) {
+        return m_fileTst->checkZoneVr(m_yaw, m_pitch);
+    } else {
+        return m_fileTst->checkZoneStatic(x, y);
+    }
+}
+
+bool Engine::EnginePrivate::isPanoramic() const
+{
+    return m_isPanoramic;
+}
+
+void Engine::EnginePrivate::markFrameBufferDirty()
+{
+    m_dirtyRegion.addAll();
+}
+
+void Engine::EnginePrivate::markFrameBufferDirty(int x, int y, int width, int height)
+{
+    m_dirtyRegion.add(x, y, width, height);
+}
+
+uint32_t Engine::EnginePrivate::visiblePanoramaFaces() const
+{
+    // Cube face normals, in image order: down, left, up, right, front, back
+    static const float faceNormals[PANORAMA_FACE_COUNT][3] = {
+        { 0.0f, -1.0f, 0.0f },
+        { -1.0f, 0.0f, 0.0f },
+        { 0.0f, 1.0f, 0.0f },
+        { 1.0f, 0.0f, 0.0f },
+        { 0.0f, 0.0f, -1.0f },
+        { 0.0f, 0.0f, 1.0f },
+    };
+
+    int width;
+    int height;
+    SDL_GetWindowSize(m_window, &width, &height);
+    const float aspect = height > 0 ? (float)width / height : 1.0f;
+
+    // View cone covering the window diagonal, plus the face corner angle and a safety margin
+    const float toRadians = std::numbers::pi_v<float> / 180.0f;
+    const float viewHalfAngle = std::atan(std::tan(WINDOW_FOV / 2.0f) * std::sqrt(1.0f + aspect * aspect));
+    const float faceHalfAngle = std::acos(1.0f / std::sqrt(3.0f));
+    const float maxAngle = viewHalfAngle + faceHalfAngle + PANORAMA_CULL_MARGIN * toRadians;
+    if (maxAngle >= std::numbers::pi_v<float>) {
+        return (1u << PANORAMA_FACE_COUNT) - 1;
+    }
+
+    // View direction, yaw 270 looks at the front face, pitch 0 looks down
+    const float yaw = m_yaw * toRadians;
+    const float pitch = m_pitch * toRadians;
+    const float view[3] = { std::cos(yaw) * std::sin(pitch), -std::cos(pitch), std::sin(yaw) * std::sin(pitch) };
+
+    uint32_t faces = 0;
+    for (int face = 0; face < PANORAMA_FACE_COUNT; face++) {
+        const float* normal = faceNormals[face];
+        if (view[0] * normal[0] + view[1] * normal[1] + view[2] * normal[2] > std::cos(maxAngle)) {
+            faces |= 1u << face;
+        }
+    }
+
+    return faces;
+}
+
+void Engine::EnginePrivate::applyAnimationSteps(const std::string& animName, int lastStep, uint32_t visibleFaces)
+{
+    int& appliedStep = m_animationSteps.try_emplace(animName, -1).first->second;
+    if (lastStep <= appliedStep) {
+        return;
+    }
+
+    const VrAnimationIndex::Animation* animation = m_vrAnimationIndex ? m_vrAnimationIndex->animation(animName) : nullptr;
+
+    // Decoded by ofnx, every step has to be applied in turn
+    if (!animation || !m_vrAnimationIndex->isDecoded()) {
+        for (; appliedStep < lastStep; appliedStep++) {
+            m_fileVr->applyAnimationFrameRgb565(animName, m_vrImageData.data());
+
+            if (animation) {
+                for (uint32_t blockOffset : animation->footprint) {
+                    m_dirtyRegion.addBlock(blockOffset);
+                }
+            } else {
+                markFrameBufferDirty();
+            }
+            m_warpStats.animationFrameCount++;
+        }
+        return;
+    }
+
+    if (animation->frames.empty()) {
+        appliedStep = lastStep;
+        return;
+    }
+
+    // Hidden animations are caught up once back in view
+    if (isPanoramic()) {
+        uint32_t faces = 0;
+        for (int face = 0; face < PANORAMA_FACE_COUNT; face++) {
+            if (animation->tileMask & (PANORAMA_FACE_TILES << (face * PANORAMA_TILES_PER_FACE))) {
+                faces |= 1u << face;
+            }
+        }
+
+        if (!(faces & visibleFaces)) {
+            return;
+        }
+    }
+
+    // A whole cycle rewrites every block of the animation, older steps are overwritten anyway
+    const int frameCount = (int)animation->frames.size();
+    const int firstStep = std::max(appliedStep + 1, lastStep - frameCount + 1);
+    m_warpStats.animationSkippedFrameCount += firstStep - appliedStep - 1;
+
+    const int width = isPanoramic() ? ENGINE_PANORAMA_WIDTH : ENGINE_WIDTH;
+    for (int step = firstStep; step <= lastStep; step++) {
+        const VrAnimationIndex::Frame& frame = animation->frames[step % frameCount];
+        VrAnimationIndex::applyFrame(frame, m_vrImageData.data(), width);
+        for (uint32_t blockOffset : frame.blockOffsets) {
+            m_dirtyRegion.addBlock(blockOffset);
+        }
+    }
+    m_warpStats.animationFrameCount += lastStep - firstStep + 1;
+
+    appliedStep = lastStep;
+}
+
+void Engine::EnginePrivate::markInputTime(uint64_t timestampNs)
+{
+    if (m_inputTimeNs == 0) {
+        m_inputTimeNs = timestampNs;
+    }
+}
+
+bool Engine::EnginePrivate::needsPresent() const
+{
+    // Cursor is drawn by the system and does not need a present
+    return m_isViewChanged || !m_dirtyRegion.isEmpty();
+}
+
+int Engine::EnginePrivate::idleTimeoutMs() const
+{
+    // Wake up in time for the next animation frame
+    const double animationMs = std::ceil(m_animationTimeline.secondsToNextStep() * 1000.0);
+
+    return (int)std::clamp(animationMs, 1.0, (double)ENGINE_IDLE_TIMEOUT_MS);
+}
 
-                m_functions[instruction.name](*parent, instruction.params);
+void Engine::EnginePrivate::updateAnimations(double elapsedSeconds)
+{
+    // Frames are applied only when their clock reaches them
+    const auto animationStart = std::chrono::steady_clock::now();
+    const double elapsed = std::min(elapsedSeconds, ANIMATION_MAX_ELAPSED);
 
-                if (instruction.name == "gotowarp") {
-                    // TODO: check if this is the best way to handle this
-                    return;
-                }
+    if (!m_animationTimeline.isEmpty()) {
+        const std::vector<AnimationTimeline::Track> finishedTracks = m_animationTimeline.update(elapsed);
+        const uint32_t visibleFaces = isPanoramic() ? visiblePanoramaFaces() : 0;
+
+        for (const AnimationTimeline::Track& track : m_animationTimeline.tracks()) {
+            applyAnimationSteps(track.name, track.steps - 1, visibleFaces);
+        }
+
+        for (const AnimationTimeline::Track& track : finishedTracks) {
+            applyAnimationSteps(track.name, track.steps - 1, visibleFaces);
+            m_animationSteps.erase(track.name);
+
+            if (!track.variable.empty()) {
+                m_stateVariables.set(track.variable, 1.0);
             }
         }
-    } catch (const std::exception& e) {
-        LOG_ERROR("Error during script execution");
-        m_isRunning = false;
+
+        m_warpStats.animationMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - animationStart).count();
     }
 }
 
-void Engine::EnginePrivate::executeBlockPlugin(const ofnx::files::Lst::InstructionBlock& block)
+void Engine::EnginePrivate::addCameraSample(uint64_t timestampNs)
 {
-    try {
-        for (const ofnx::files::Lst::Instruction& instruction : block) {
-            if (m_functionsPlugin.find(instruction.name) == m_functionsPlugin.end()) {
-                LOG_ERROR("Script plugin function not found: {}", instruction.name);
-                continue;
-            }
+    m_cameraPrevious = m_cameraLast;
+    m_cameraLast = { timestampNs, m_yaw, m_pitch };
+}
 
-            m_functionsPlugin[instruction.name](*parent, instruction.params);
-        }
-    } catch (const std::exception& e) {
-        LOG_ERROR("Error during script execution");
-        m_isRunning = false;
+void Engine::EnginePrivate::resetCamera()
+{
+    m_cameraLast = { SDL_GetTicksNS(), m_yaw, m_pitch };
+    m_cameraPrevious = m_cameraLast;
+}
+
+bool Engine::EnginePrivate::interpolateCamera(float& yaw, float& pitch) const
+{
+    // Moves from the previous input sample to the last one over the time that separated them
+    const uint64_t intervalNs = m_cameraLast.timestampNs - m_cameraPrevious.timestampNs;
+    const uint64_t nowNs = SDL_GetTicksNS();
+    float t = 1.0f;
+    if (intervalNs > 0 && intervalNs < CAMERA_MAX_INTERVAL_NS && nowNs > m_cameraLast.timestampNs) {
+        t = std::min(1.0f, (float)(nowNs - m_cameraLast.timestampNs) / intervalNs);
+    } else if (intervalNs > 0 && intervalNs < CAMERA_MAX_INTERVAL_NS) {
+        t = 0.0f;
+    }
+
+    // Shortest way around for yaw
+    float yawDelta = m_cameraLast.yaw - m_cameraPrevious.yaw;
+    if (yawDelta > 180.0f) {
+        yawDelta -= 360.0f;
+    } else if (yawDelta < -180.0f) {
+        yawDelta += 360.0f;
     }
+
+    yaw = m_cameraPrevious.yaw + yawDelta * t;
+    pitch = m_cameraPrevious.pitch + (m_cameraLast.pitch - m_cameraPrevious.pitch) * t;
+
+    // Input after the last sample is not interpolated yet
+    if (t >= 1.0f) {
+        yaw = m_yaw;
+        pitch = m_pitch;
+    }
+
+    return t >= 1.0f;
 }
 
-bool Engine::EnginePrivate::isPanoramic() const
+const uint16_t* Engine::EnginePrivate::fadedImageData()
 {
-    return m_fileVr.getType() == ofnx::files::Vr::Type::VR_STATIC_VR;
+    // Faded value of each RGB565 component, already shifted in place
+    uint16_t fadeR[32];
+    uint16_t fadeG[64];
+    uint16_t fadeB[32];
+    for (int i = 0; i < 64; i++) {
+        if (i < 32) {
+            fadeR[i] = (uint16_t)(std::clamp(static_cast<int>(i + m_fadeLevel), 0, 255) << 11);
+            fadeB[i] = (uint16_t)std::clamp(static_cast<int>(i + m_fadeLevel), 0, 255);
+        }
+        fadeG[i] = (uint16_t)(std::clamp(static_cast<int>(i + m_fadeLevel), 0, 255) << 5);
+    }
+
+    // Single pass from the frame buffer to the upload copy
+    m_fadedImageData.resize(m_vrImageData.size());
+    const uint16_t* src = m_vrImageData.data();
+    uint16_t* dst = m_fadedImageData.data();
+    for (size_t i = 0; i < m_vrImageData.size(); i++) {
+        const uint16_t pixel = src[i];
+        dst[i] = fadeR[(pixel >> 11) & 0x1F] | fadeG[(pixel >> 5) & 0x3F] | fadeB[pixel & 0x1F];
+    }
+
+    return m_fadedImageData.data();
 }
 
 void Engine::EnginePrivate::render()
 {
-    // Update animations
-    for (const std::string& animName : m_playingAnim) {
-        m_fileVr.applyAnimationFrameRgb565(animName, m_vrImageData.data());
+    if (m_isRenderOnDemand && !needsPresent()) {
+        m_frameDirtyBytes = 0;
+        m_frameUploadBytes = 0;
+        m_skippedPresentCount++;
+        return;
+    }
+    m_presentCount++;
+
+    // Upload image only if it changed since the last upload, the renderer takes whole images
+    m_frameDirtyBytes = m_dirtyRegion.area() * sizeof(uint16_t);
+    m_frameUploadBytes = 0;
+    if (!m_dirtyRegion.isEmpty()) {
+        const uint16_t* imageData = m_isFading ? fadedImageData() : m_vrImageData.data();
+        if (isPanoramic()) {
+            m_rendererOgl.updateVr(imageData);
+        } else {
+            m_rendererOgl.updateFrame(imageData);
+        }
+
+        m_frameUploadBytes = m_vrImageData.size() * sizeof(uint16_t);
+        m_dirtyRegion.clear();
     }
 
     // Render
     if (isPanoramic()) {
+        float yaw;
+        float pitch;
+        m_isViewChanged = !interpolateCamera(yaw, pitch);
+
         int width;
         int height;
         SDL_GetWindowSize(m_window, &width, &height);
-        m_rendererOgl.updateVr(m_vrImageData.data());
-        m_rendererOgl.renderVr(width, height, m_yaw, m_pitch, m_roll, WINDOW_FOV);
+        m_rendererOgl.renderVr(width, height, yaw, pitch, m_roll, WINDOW_FOV);
         SDL_GL_SwapWindow(m_window);
     } else {
-        m_rendererOgl.updateFrame(m_vrImageData.data());
+        m_isViewChanged = false;
         m_rendererOgl.renderFrame();
         SDL_GL_SwapWindow(m_window);
     }
+
+    if (m_presentCount == 1) {
+        m_startupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_startTime).count();
+        LOG_INFO("First frame presented {:.2f} ms after startup, script {} in {:.2f} ms",
+            m_startupMs,
+            m_scriptStats.isCached ? "mapped" : "parsed",
+            m_scriptStats.loadMs);
+    }
+
+    // Input handled since the last present is now visible
+    if (m_inputTimeNs != 0) {
+        const uint64_t nowNs = SDL_GetTicksNS();
+        const double latencyMs = nowNs > m_inputTimeNs ? (nowNs - m_inputTimeNs) / 1000000.0 : 0.0;
+        m_inputTimeNs = 0;
+
+        m_inputLatency.count++;
+        m_inputLatency.lastMs = latencyMs;
+        m_inputLatency.averageMs += (latencyMs - m_inputLatency.averageMs) / m_inputLatency.count;
+        m_inputLatency.maxMs = std::max(m_inputLatency.maxMs, latencyMs);
+    }
 }
 
 void Engine::EnginePrivate::setCursorSettings(bool visible, bool centerLocked)
@@ -586,30 +1563,46 @@ void Engine::EnginePrivate::setCursorSystem(const CursorSystem& cursor)
     SDL_SetCursor(m_cursor);
 }
 
-void Engine::EnginePrivate::setCursor(const std::string& cursorFile)
+SDL_Surface* Engine::EnginePrivate::loadCursorSurface(const std::string& cursorFile)
 {
+    // Thread-safe, surfaces are kept until deinit
+    std::lock_guard<std::mutex> lock(m_cursorMutex);
+    if (m_cursorSurfaces.contains(cursorFile)) {
+        return m_cursorSurfaces[cursorFile];
+    }
+
     SDL_Surface* cursorSurface = IMG_Load(cursorFile.c_str());
     if (!cursorSurface) {
         LOG_ERROR("Failed to load image: {}", SDL_GetError());
-        return;
+        return nullptr;
     }
 
     const SDL_PixelFormatDetails* formatDetails = SDL_GetPixelFormatDetails(cursorSurface->format);
     if (!formatDetails) {
         LOG_ERROR("Failed to get format details: {}", SDL_GetError());
         SDL_DestroySurface(cursorSurface);
-        return;
+        return nullptr;
     }
 
     Uint32 key = SDL_MapRGBA(formatDetails, NULL, 0, 0, 0, 0);
     SDL_SetSurfaceColorKey(cursorSurface, true, key);
 
+    m_cursorSurfaces[cursorFile] = cursorSurface;
+
+    return cursorSurface;
+}
+
+void Engine::EnginePrivate::setCursor(const std::string& cursorFile)
+{
+    SDL_Surface* cursorSurface = loadCursorSurface(cursorFile);
+    if (!cursorSurface) {
+        return;
+    }
+
     int hotX = cursorSurface->w / 2;
     int hotY = cursorSurface->h / 2;
     SDL_Cursor* cursor = SDL_CreateColorCursor(cursorSurface, hotX, hotY);
 
-    SDL_DestroySurface(cursorSurface);
-
     if (!cursor) {
         LOG_ERROR("Failed to create SDL cursor: {}", SDL_GetError());
         return;
@@ -628,6 +1621,7 @@ Engine::Engine()
 {
     d_ptr = new EnginePrivate();
     d_ptr->parent = this;
+    d_ptr->m_warpCache.setBudget(WARP_CACHE_RAW_BUDGET, WARP_CACHE_DECODED_BUDGET);
 
     av_log_set_level(AV_LOG_ERROR);
 }
@@ -637,7 +1631,7 @@ Engine::~Engine()
     delete d_ptr;
 }
 
-bool Engine::init()
+bool Engine::init(int workerCount)
 {
     // Init SDL3
     if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO)) {
@@ -667,6 +1661,15 @@ bool Engine::init()
     // Disable VSync
     SDL_GL_SetSwapInterval(0);
 
+    // Panoramas are rendered at the display refresh rate
+    int renderFps = RENDER_FPS_DEFAULT;
+    const SDL_DisplayMode* displayMode = SDL_GetCurrentDisplayMode(SDL_GetDisplayForWindow(d_ptr->m_window));
+    if (displayMode && displayMode->refresh_rate > 0.0f) {
+        renderFps = std::clamp((int)std::lround(displayMode->refresh_rate), ENGINE_FPS, RENDER_FPS_MAX);
+    }
+    d_ptr->m_renderDelay = std::chrono::nanoseconds(1000000000 / renderFps);
+    LOG_INFO("Rendering panoramas at {} FPS", renderFps);
+
     // Init engine objects
     // TODO: manage old/new VR version
     if (!d_ptr->m_rendererOgl.init(ENGINE_WIDTH, ENGINE_HEIGHT, false, (ofnx::graphics::RendererOpenGL::oglLoadFunc)SDL_GL_GetProcAddress)) {
@@ -693,139 +1696,187 @@ bool Engine::init()
         return false;
     }
 
+    if (workerCount < 0) {
+        workerCount = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+    }
+    d_ptr->m_threadPool.init(workerCount);
+
+    // One worker stays free for the current warp loads, without a second one there is no prefetching
+    if (!d_ptr->m_prefetcher.init(
+            &d_ptr->m_threadPool,
+            [this](const std::string& warpName) { d_ptr->prefetchWarp(warpName); },
+            PREFETCH_QUEUE_SIZE,
+            workerCount - 1)) {
+        LOG_INFO("Warp prefetching disabled with {} worker(s)", workerCount);
+    }
+
     // Init data
     d_ptr->m_dataPath = ENGINE_DATA_PATH;
     d_ptr->m_isInit = true;
 
-    d_ptr->registerScriptFunction("gotowarp", &fvrGotoWarp);
-    d_ptr->registerScriptFunction("playsound", &fvrPlaySound);
-    d_ptr->registerScriptFunction("stopsound", &fvrStopSound);
-    d_ptr->registerScriptFunction("playsound3d", &fvrPlaySound3d);
-    d_ptr->registerScriptFunction("stopsound3d", &fvrStopSound3d);
-    d_ptr->registerScriptFunction("playmusique", &fvrPlayMusic);
-    d_ptr->registerScriptFunction("stopmusique", &fvrStopMusic);
-    d_ptr->registerScriptFunction("set", &fvrSet);
-    d_ptr->registerScriptFunction("lockkey", &fvrLockKey);
+    d_ptr->registerScriptFunction<&fvrGotoWarp>("gotowarp");
+    d_ptr->registerScriptFunction<&fvrPlaySound>("playsound");
+    d_ptr->registerScriptFunction<&fvrStopSound>("stopsound");
+    d_ptr->registerScriptFunction<&fvrPlaySound3d>("playsound3d");
+    d_ptr->registerScriptFunction<&fvrStopSound3d>("stopsound3d");
+    d_ptr->registerScriptFunction<&fvrPlayMusic>("playmusique");
+    d_ptr->registerScriptFunction<&fvrStopMusic>("stopmusique");
+    d_ptr->registerScriptFunction<&fvrSet>("set");
+    d_ptr->registerScriptFunction<&fvrLockKey>("lockkey");
     d_ptr->registerScriptFunction("resetlockkey", &fvrResetLockKey);
-    d_ptr->registerScriptFunction("setcursor", &fvrSetCursor);
-    d_ptr->registerScriptFunction("setcursordefault", &fvrSetCursorDefault);
-    d_ptr->registerScriptFunction("fade", &fvrFade);
+    d_ptr->registerScriptFunction<&fvrSetCursor>("setcursor");
+    d_ptr->registerScriptFunction<&fvrSetCursorDefault>("setcursordefault");
+    d_ptr->registerScriptFunction<&fvrFade>("fade");
     d_ptr->registerScriptFunction("end", &fvrEnd);
-    d_ptr->registerScriptFunction("setangle", &fvrSetAngle);
-    d_ptr->registerScriptFunction("hidecursor", &fvrHideCursor);
-    d_ptr->registerScriptFunction("not", &fvrNot);
-    d_ptr->registerScriptFunction("anglexmax", &fvrAngleXMax);
-    d_ptr->registerScriptFunction("angleymax", &fvrAngleYMax);
-    d_ptr->registerScriptFunction("setzoom", &fvrSetZoom);
-    d_ptr->registerScriptFunction("interpolangle", &fvrInterpolAngle);
+    d_ptr->registerScriptFunction<&fvrSetAngle>("setangle");
+    d_ptr->registerScriptFunction<&fvrHideCursor>("hidecursor");
+    d_ptr->registerScriptFunction<&fvrNot>("not");
+    d_ptr->registerScriptFunction<&fvrAngleXMax>("anglexmax");
+    d_ptr->registerScriptFunction<&fvrAngleYMax>("angleymax");
+    d_ptr->registerScriptFunction<&fvrSetZoom>("setzoom");
+    d_ptr->registerScriptFunction<&fvrInterpolAngle>("interpolangle");
 
     return true;
 }
 
 void Engine::loop()
 {
+    d_ptr->m_startTime = std::chrono::steady_clock::now();
+
     // Load initial script
     if (!d_ptr->loadScript(d_ptr->m_dataPath + "script/script_1.lst")) {
         LOG_ERROR("Failed to load initial script");
         return;
     }
 
-    const std::chrono::milliseconds frameDelay(1000 / ENGINE_FPS);
+    const std::chrono::nanoseconds tickDelay(1000000000 / ENGINE_FPS);
 
     int frameCount = 0;
     d_ptr->m_lastTime = std::chrono::high_resolution_clock::now();
+    d_ptr->m_lastRenderTime = d_ptr->m_lastTime;
 
     gotoWarp("init.vr");
 
     while (d_ptr->m_isRunning) {
-        auto currentTime = std::chrono::high_resolution_clock::now();
-        auto elapsedTime = std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - d_ptr->m_lastTime);
-
+        // Input is handled as soon as it arrives, only rendering waits for the next frame
         int pointedZone = d_ptr->m_pointedZone;
 
-        if (elapsedTime >= frameDelay) {
-            d_ptr->m_lastTime = currentTime;
+        std::vector<EventManager::Event> events = d_ptr->m_event.getEvents();
+        for (const EventManager::Event& event : events) {
+            if (d_ptr->m_keyWarp.find(event.type) != d_ptr->m_keyWarp.end()) {
+                gotoWarp(d_ptr->m_keyWarp[event.type]);
+            }
 
-            // Update
-            std::vector<EventManager::Event> events = d_ptr->m_event.getEvents();
-            for (const EventManager::Event& event : events) {
-                if (d_ptr->m_keyWarp.find(event.type) != d_ptr->m_keyWarp.end()) {
-                    gotoWarp(d_ptr->m_keyWarp[event.type]);
-                }
+            switch (event.type) {
+            case EventManager::Event::Type::Quit:
+                d_ptr->m_isRunning = false;
+                break;
+            case EventManager::Event::Type::MouseMove:
+                if (isPanoramic()) {
+                    d_ptr->m_yaw += event.xRel * MOUSE_SENSITIVITY;
+                    d_ptr->m_pitch -= event.yRel * MOUSE_SENSITIVITY;
+
+                    if (d_ptr->m_yaw < 0.0f) {
+                        d_ptr->m_yaw = 360.0f;
+                    } else if (d_ptr->m_yaw > 360.0f) {
+                        d_ptr->m_yaw = 0.0f;
+                    }
 
-                switch (event.type) {
-                case EventManager::Event::Type::Quit:
-                    d_ptr->m_isRunning = false;
-                    break;
-                case EventManager::Event::Type::MouseMove:
-                    if (isPanoramic()) {
-                        d_ptr->m_yaw += event.xRel * MOUSE_SENSITIVITY;
-                        d_ptr->m_pitch -= event.yRel * MOUSE_SENSITIVITY;
-
-                        if (d_ptr->m_yaw < 0.0f) {
-                            d_ptr->m_yaw = 360.0f;
-                        } else if (d_ptr->m_yaw > 360.0f) {
-                            d_ptr->m_yaw = 0.0f;
-                        }
+                    if (d_ptr->m_pitch < 0.0f) {
+                        d_ptr->m_pitch = 0.0f;
+                    } else if (d_ptr->m_pitch > 360.0f) {
+                        d_ptr->m_pitch = 0.0f;
+                    }
 
-                        if (d_ptr->m_pitch < 0.0f) {
-                            d_ptr->m_pitch = 0.0f;
-                        } else if (d_ptr->m_pitch > 360.0f) {
-                            d_ptr->m_pitch = 0.0f;
-                        }
+                    d_ptr->m_pitch = std::clamp(d_ptr->m_pitch, 0.0f, 180.0f);
+                    d_ptr->m_isViewChanged = true;
+                    d_ptr->addCameraSample(event.timestampNs);
+                    d_ptr->markInputTime(event.timestampNs);
+                }
 
-                        d_ptr->m_pitch = std::clamp(d_ptr->m_pitch, 0.0f, 180.0f);
+                pointedZone = d_ptr->checkZone((float)event.x, (float)event.y);
+                break;
+            case EventManager::Event::Type::MouseClickLeft:
+                int zoneIndex;
 
-                        pointedZone = d_ptr->m_fileTst.checkZoneVr(d_ptr->m_yaw, d_ptr->m_pitch);
-                    } else {
-                        pointedZone = d_ptr->m_fileTst.checkZoneStatic((float)event.x, (float)event.y);
-                    }
+                // A click skips the running waits before reaching zones
+                if (d_ptr->m_scripts.skip()) {
                     break;
-                case EventManager::Event::Type::MouseClickLeft:
-                    int zoneIndex;
-
-                    if (isPanoramic()) {
-                        zoneIndex = d_ptr->m_fileTst.checkZoneVr(d_ptr->m_yaw, d_ptr->m_pitch);
-                    } else {
-                        zoneIndex = d_ptr->m_fileTst.checkZoneStatic((float)event.x, (float)event.y);
-                    }
+                }
 
-                    if (zoneIndex >= 0) {
-                        d_ptr->onWarpZoneClick(d_ptr->m_currentWarp, zoneIndex);
-                    }
+                zoneIndex = d_ptr->checkZone((float)event.x, (float)event.y);
 
-                    break;
+                // Zones of the warp being left are inactive
+                if (zoneIndex >= 0 && d_ptr->m_transitions.empty()) {
+                    d_ptr->markInputTime(event.timestampNs);
+                    d_ptr->onWarpZoneClick(d_ptr->m_currentWarpId, zoneIndex);
                 }
+
+                break;
+            case EventManager::Event::Type::WindowChanged:
+                d_ptr->m_isViewChanged = true;
+                break;
+            case EventManager::Event::Type::ToggleScriptProfiling:
+                setScriptProfiling(!isScriptProfiling());
+                break;
             }
+        }
 
-            if (pointedZone != d_ptr->m_pointedZone) {
-                d_ptr->m_pointedZone = pointedZone;
+        if (pointedZone != d_ptr->m_pointedZone) {
+            d_ptr->m_pointedZone = pointedZone;
 
-                if (d_ptr->m_warpZoneCursor.contains(d_ptr->m_pointedZone)) {
-                    d_ptr->setCursor(ENGINE_DATA_PATH "image/" + d_ptr->m_warpZoneCursor[d_ptr->m_pointedZone]);
+            if (d_ptr->m_warpZoneCursor.contains(d_ptr->m_pointedZone)) {
+                d_ptr->setCursor(ENGINE_DATA_PATH "image/" + d_ptr->m_warpZoneCursor[d_ptr->m_pointedZone]);
+            } else {
+                if (d_ptr->m_pointedZone == -1) {
+                    if (d_ptr->m_defaultCursor.contains(0)) {
+                        d_ptr->setCursor(ENGINE_DATA_PATH "image/" + d_ptr->m_defaultCursor[0]);
+                    } else {
+                        d_ptr->setCursorSystem(EnginePrivate::CursorSystem::Default);
+                    }
                 } else {
-                    if (d_ptr->m_pointedZone == -1) {
-                        if (d_ptr->m_defaultCursor.contains(0)) {
-                            d_ptr->setCursor(ENGINE_DATA_PATH "image/" + d_ptr->m_defaultCursor[0]);
-                        } else {
-                            d_ptr->setCursorSystem(EnginePrivate::CursorSystem::Default);
-                        }
+                    if (d_ptr->m_defaultCursor.contains(1)) {
+                        d_ptr->setCursor(ENGINE_DATA_PATH "image/" + d_ptr->m_defaultCursor[1]);
                     } else {
-                        if (d_ptr->m_defaultCursor.contains(1)) {
-                            d_ptr->setCursor(ENGINE_DATA_PATH "image/" + d_ptr->m_defaultCursor[1]);
-                        } else {
-                            d_ptr->setCursorSystem(EnginePrivate::CursorSystem::Default);
-                        }
+                        d_ptr->setCursorSystem(EnginePrivate::CursorSystem::Default);
                     }
                 }
+            }
 
-                SDL_SetWindowTitle(d_ptr->m_window, std::string("Pointed zone: " + std::to_string(d_ptr->m_pointedZone)).c_str());
+            SDL_SetWindowTitle(d_ptr->m_window, std::string("Pointed zone: " + std::to_string(d_ptr->m_pointedZone)).c_str());
+        }
+
+        // Game logic runs on a fixed tick, whatever the render rate
+        auto currentTime = std::chrono::high_resolution_clock::now();
+        int tickCount = 0;
+        while (currentTime - d_ptr->m_lastTime >= tickDelay) {
+            if (++tickCount > ENGINE_MAX_TICKS) {
+                d_ptr->m_lastTime = currentTime;
+                break;
             }
 
+            d_ptr->m_lastTime += tickDelay;
+            d_ptr->updateTransition();
+            d_ptr->m_scripts.update(1.0 / ENGINE_FPS);
+            d_ptr->updateAnimations(1.0 / ENGINE_FPS);
+        }
+
+        // Static images only change on ticks, panoramas follow the display
+        const std::chrono::nanoseconds renderDelay = isPanoramic() ? d_ptr->m_renderDelay : tickDelay;
+        if (currentTime - d_ptr->m_lastRenderTime >= renderDelay) {
+            d_ptr->m_lastRenderTime = currentTime;
             d_ptr->render();
-        } else {
-            std::this_thread::sleep_for(frameDelay - elapsedTime);
+            continue;
+        }
+
+        // Wait for input until the next tick or frame is due
+        const auto nextTime = std::min(d_ptr->m_lastTime + tickDelay, d_ptr->m_lastRenderTime + renderDelay);
+        int timeoutMs = (int)std::ceil(std::chrono::duration<double, std::milli>(nextTime - currentTime).count());
+        if (d_ptr->m_isRenderOnDemand && d_ptr->m_transitions.empty() && d_ptr->m_scripts.isIdle() && !d_ptr->needsPresent()) {
+            // Nothing to show before some input or the next animation frame
+            timeoutMs = std::max(timeoutMs, d_ptr->idleTimeoutMs());
         }
+        d_ptr->m_event.waitEvents(std::max(timeoutMs, 0));
     }
 }
 
@@ -835,6 +1886,14 @@ void Engine::deinit()
         return;
     }
 
+    d_ptr->m_transitions.clear();
+    d_ptr->m_requestedTransition = nullptr;
+    d_ptr->m_scripts.cancel();
+    if (!d_ptr->m_profiler.isEmpty()) {
+        d_ptr->logScriptProfile();
+    }
+    d_ptr->m_prefetcher.deinit();
+    d_ptr->m_threadPool.deinit();
     d_ptr->m_audio.deinit();
     d_ptr->m_event.deinit();
     d_ptr->m_rendererOgl.deinit();
@@ -844,6 +1903,11 @@ void Engine::deinit()
         d_ptr->m_cursor = nullptr;
     }
 
+    for (auto& cursorSurface : d_ptr->m_cursorSurfaces) {
+        SDL_DestroySurface(cursorSurface.second);
+    }
+    d_ptr->m_cursorSurfaces.clear();
+
     SDL_GL_DestroyContext(d_ptr->m_glContext);
     SDL_DestroyWindow(d_ptr->m_window);
     SDL_Quit();
@@ -852,13 +1916,18 @@ void Engine::deinit()
 }
 
 void Engine::registerScriptPluginFunction(const std::string& name, const ScriptFunction& function)
+{
+    registerScriptPluginBinding(name, makeScriptBinding(function));
+}
+
+void Engine::registerScriptPluginBinding(const std::string& name, const ScriptBinding& binding)
 {
     if (d_ptr->m_functionsPlugin.find(name) != d_ptr->m_functionsPlugin.end()) {
         LOG_ERROR("Script plugin function already registered: {}", name);
         return;
     }
 
-    d_ptr->m_functionsPlugin[name] = function;
+    d_ptr->m_functionsPlugin[name] = binding;
 }
 
 bool Engine::isPanoramic() const
@@ -878,9 +1947,102 @@ int Engine::pointedZone() const
 
 std::vector<uint16_t>& Engine::getFrameBuffer()
 {
+    // Caller is expected to draw anywhere into the buffer
+    d_ptr->markFrameBufferDirty();
+
+    return d_ptr->m_vrImageData;
+}
+
+std::vector<uint16_t>& Engine::getFrameBuffer(int x, int y, int width, int height)
+{
+    // Caller is expected to draw only inside the given rectangle
+    d_ptr->markFrameBufferDirty(x, y, width, height);
+
     return d_ptr->m_vrImageData;
 }
 
+void Engine::markFrameBufferDirty(int x, int y, int width, int height)
+{
+    d_ptr->markFrameBufferDirty(x, y, width, height);
+}
+
+size_t Engine::getFrameDirtyBytes() const
+{
+    return d_ptr->m_frameDirtyBytes;
+}
+
+size_t Engine::getFrameUploadBytes() const
+{
+    return d_ptr->m_frameUploadBytes;
+}
+
+void Engine::setRenderOnDemand(bool enabled)
+{
+    d_ptr->m_isRenderOnDemand = enabled;
+    d_ptr->m_isViewChanged = true;
+}
+
+bool Engine::isRenderOnDemand() const
+{
+    return d_ptr->m_isRenderOnDemand;
+}
+
+void Engine::setScriptProfiling(bool enabled)
+{
+    if (enabled == d_ptr->m_profiler.isEnabled()) {
+        return;
+    }
+
+    // The report covers the time profiling was on
+    if (!enabled && !d_ptr->m_profiler.isEmpty()) {
+        d_ptr->logScriptProfile();
+        d_ptr->m_profiler.clear();
+    }
+
+    d_ptr->m_profiler.setEnabled(enabled);
+    LOG_INFO("Script profiling {}", enabled ? "enabled" : "disabled");
+}
+
+bool Engine::isScriptProfiling() const
+{
+    return d_ptr->m_profiler.isEnabled();
+}
+
+Engine::ScriptStats Engine::getScriptStats() const
+{
+    ScriptStats stats = d_ptr->m_scriptStats;
+    stats.blockCount = d_ptr->m_program.blockCount();
+    stats.opCount = d_ptr->m_program.opCount();
+    stats.stringCount = d_ptr->m_program.stringCount();
+    stats.byteSize = d_ptr->m_program.byteSize();
+    stats.rejectedCount = d_ptr->m_program.rejectedCount();
+    if (stats.executionMs > 0.0) {
+        stats.instructionsPerSecond = stats.instructionCount / (stats.executionMs / 1000.0);
+    }
+
+    return stats;
+}
+
+const Engine::LatencyStats& Engine::getInputLatencyStats() const
+{
+    return d_ptr->m_inputLatency;
+}
+
+uint64_t Engine::getPresentCount() const
+{
+    return d_ptr->m_presentCount;
+}
+
+uint64_t Engine::getSkippedPresentCount() const
+{
+    return d_ptr->m_skippedPresentCount;
+}
+
+double Engine::getStartupMs() const
+{
+    return d_ptr->m_startupMs;
+}
+
 void Engine::registerKeyWarp(int key, const std::string& warpName)
 {
     // TODO: implement missing keys
@@ -928,56 +2090,79 @@ void Engine::end()
 
 void Engine::gotoWarp(const std::string& warpName)
 {
-    // Clear previous data
-    d_ptr->m_playingAnim.clear();
-    d_ptr->m_currentWarp = warpName;
-    d_ptr->m_warpZoneCursor.clear();
-    d_ptr->m_fileVr.clear();
+    // Loaded by workers, entered from the main loop once ready
+    // Requests are entered in turn, each one runs its init block
+    std::shared_ptr<EnginePrivate::WarpLoad> load = std::make_shared<EnginePrivate::WarpLoad>();
+    load->warpName = warpName;
+    load->start = std::chrono::steady_clock::now();
+    d_ptr->m_transitions.push_back(load);
+    d_ptr->m_requestedTransition = load;
+}
 
-    const std::string warpVr = d_ptr->m_dataPath + "warp/" + d_ptr->m_currentWarp;
-    if (d_ptr->m_fileVr.load(warpVr)) {
-        if (!d_ptr->m_fileVr.getDataRgb565(d_ptr->m_vrImageData)) {
-            LOG_ERROR("Failed to load VR image data");
-            return;
-        }
+bool Engine::isWarpLoading() const
+{
+    return !d_ptr->m_transitions.empty();
+}
 
-        if (isPanoramic()) {
-            d_ptr->setCursorSettings(true, true);
-        } else {
-            d_ptr->setCursorSettings(true, false);
-        }
+const Engine::WarpStats& Engine::getWarpStats() const
+{
+    return d_ptr->m_warpStats;
+}
 
-        // Load zones if available
-        // Remove '.vr' if it exists
-        std::string tmpWarpName = d_ptr->m_currentWarp;
-        if (tmpWarpName.find(".vr") != std::string::npos) {
-            tmpWarpName = tmpWarpName.substr(0, tmpWarpName.find(".vr"));
-        }
+void Engine::setWarpCacheBudget(size_t rawBytes, size_t decodedBytes)
+{
+    d_ptr->m_warpCache.setBudget(rawBytes, decodedBytes);
+}
 
-        const std::string warpTst = d_ptr->m_dataPath + "tst/" + tmpWarpName + ".tst";
-        if (!d_ptr->m_fileTst.loadFile(warpTst)) {
-        }
-    }
+Engine::PrefetchStats Engine::getPrefetchStats() const
+{
+    const Prefetcher::Stats stats = d_ptr->m_prefetcher.stats();
 
-    d_ptr->onWarpEnter(d_ptr->m_currentWarp);
+    return { stats.requested, stats.completed, stats.cancelled, stats.dropped };
 }
 
-std::string Engine::getStateValue(const std::string& key)
+Engine::WarpCacheStats Engine::getWarpCacheStats() const
 {
-    std::string s = key;
-    std::transform(s.begin(), s.end(), s.begin(),
-        [](unsigned char c) { return std::tolower(c); });
+    const auto convert = [](const WarpCache::Stats& stats) {
+        return CacheStats { stats.hits, stats.misses, stats.evictions, stats.bytes, stats.budget };
+    };
+
+    return { convert(d_ptr->m_warpCache.rawStats()), convert(d_ptr->m_warpCache.decodedStats()) };
+}
 
-    return d_ptr->m_stateValues[s];
+std::string Engine::getStateValue(const std::string& key)
+{
+    return d_ptr->m_stateVariables.getString(key);
 }
 
 void Engine::setStateValue(const std::string& key, const std::string& value)
 {
-    std::string s = key;
-    std::transform(s.begin(), s.end(), s.begin(),
-        [](unsigned char c) { return std::tolower(c); });
+    d_ptr->m_stateVariables.setString(key, value);
+}
+
+double Engine::getStateNumber(const std::string& key) const
+{
+    return d_ptr->m_stateVariables.get(key);
+}
+
+void Engine::setStateNumber(const std::string& key, double value)
+{
+    d_ptr->m_stateVariables.set(key, value);
+}
+
+int Engine::getStateSlot(const std::string& key)
+{
+    return d_ptr->m_stateVariables.slot(key);
+}
+
+double Engine::getStateNumber(int slot) const
+{
+    return d_ptr->m_stateVariables.get(slot);
+}
 
-    d_ptr->m_stateValues[s] = value;
+void Engine::setStateNumber(int slot, double value)
+{
+    d_ptr->m_stateVariables.set(slot, value);
 }
 
 void Engine::setDefaultCursor(const int index, const std::string& cursor)
@@ -987,7 +2172,21 @@ void Engine::setDefaultCursor(const int index, const std::string& cursor)
 
 void Engine::playAnim(const std::string& animName)
 {
-    d_ptr->m_playingAnim.insert(animName); // Stores the current frame
+    // Loops at the engine rate, already playing animations continue
+    if (!d_ptr->m_animationTimeline.isPlaying(animName)) {
+        d_ptr->m_animationTimeline.play(animName, 0, ENGINE_FPS);
+        d_ptr->m_animationSteps.erase(animName);
+    }
+}
+
+void Engine::playAnim(const std::string& animName, const std::string& variable, int frameCount, double speed)
+{
+    if (!variable.empty()) {
+        setStateNumber(variable, 0.0);
+    }
+
+    d_ptr->m_animationTimeline.play(animName, frameCount, speed > 0.0 ? speed : ENGINE_FPS, variable);
+    d_ptr->m_animationSteps.erase(animName);
 }
 
 void Engine::playSound(const std::string& soundFile, uint8_t volume, bool loop)
@@ -1258,6 +2457,9 @@ void Engine::playMovie(const std::string& movieFile)
     }
     avformat_close_input(&formatContext);
 
+    // Movie frames replaced the frame texture content
+    d_ptr->markFrameBufferDirty();
+
     SDL_ShowCursor();
 }
 
@@ -1265,114 +2467,51 @@ void Engine::setAngle(const float pitch, const float yaw)
 {
     d_ptr->m_pitch = pitch;
     d_ptr->m_yaw = yaw;
+    d_ptr->resetCamera();
+    d_ptr->m_isViewChanged = true;
 }
 
 void Engine::fade(int start, int end, int timer)
 {
-    std::vector<uint16_t> imageDataBak = d_ptr->m_vrImageData;
+    // Applied when the frame buffer is uploaded, animations keep drawing underneath
+    const double duration = timer; // Total fade duration in seconds
 
-    const std::chrono::milliseconds frameDelay(1000 / ENGINE_FPS);
-    double duration = timer; // total fade duration in seconds
-    double elapsed = 0.0;
-    double currentFade = start;
-
-    auto lastTime = std::chrono::high_resolution_clock::now();
-    while (elapsed < duration) {
-        auto currentTime = std::chrono::high_resolution_clock::now();
-        double delta = std::chrono::duration<double>(currentTime - lastTime).count();
-        lastTime = currentTime;
-
-        elapsed += delta;
-        double t = std::clamp(elapsed / duration, 0.0, 1.0);
+    const auto update = [this, start, end, duration](double elapsed) {
+        double t = duration > 0.0 ? std::clamp(elapsed / duration, 0.0, 1.0) : 1.0;
 
         // Linear interpolation
-        currentFade = start + t * (end - start);
-
-        for (uint16_t& pixel : d_ptr->m_vrImageData) {
-            int r = (pixel >> 11) & 0x1F; // 5 bits
-            int g = (pixel >> 5) & 0x3F; // 6 bits
-            int b = pixel & 0x1F; // 5 bits
+        d_ptr->m_fadeLevel = start + t * (end - start);
+        d_ptr->m_isFading = true;
+        d_ptr->markFrameBufferDirty();
 
-            r = std::clamp(static_cast<int>(r + currentFade), 0, 255);
-            g = std::clamp(static_cast<int>(g + currentFade), 0, 255);
-            b = std::clamp(static_cast<int>(b + currentFade), 0, 255);
-
-            pixel = (r << 11) | (g << 5) | b;
-        }
-        d_ptr->render();
-        d_ptr->m_vrImageData = imageDataBak;
+        return elapsed >= duration;
+    };
 
-        std::this_thread::sleep_for(frameDelay);
+    const auto finish = [this]() {
+        d_ptr->m_isFading = false;
+        d_ptr->markFrameBufferDirty();
+    };
 
-        // Update events
-        std::vector<EventManager::Event> events = d_ptr->m_event.getEvents();
-        for (const EventManager::Event& event : events) {
-            switch (event.type) {
-            case EventManager::Event::Type::MouseClickLeft:
-                return;
-            }
-        }
-    }
+    update(0.0);
+    d_ptr->m_scripts.request(update, finish);
 }
 
 void Engine::whileLoop(int timer)
 {
-    std::vector<uint16_t> imageDataBak = d_ptr->m_vrImageData;
-
-    const std::chrono::milliseconds frameDelay(1000 / ENGINE_FPS);
-    double duration = timer; // Total fade duration in seconds
-    double elapsed = 0.0;
-
-    auto lastTime = std::chrono::high_resolution_clock::now();
-    while (elapsed < duration) {
-        auto currentTime = std::chrono::high_resolution_clock::now();
-        double delta = std::chrono::duration<double>(currentTime - lastTime).count();
-        lastTime = currentTime;
-
-        elapsed += delta;
+    const double duration = timer; // Total wait duration in seconds
 
-        d_ptr->render();
-
-        std::this_thread::sleep_for(frameDelay);
-
-        // Update events
-        std::vector<EventManager::Event> events = d_ptr->m_event.getEvents();
-        for (const EventManager::Event& event : events) {
-            switch (event.type) {
-            case EventManager::Event::Type::MouseClickLeft:
-                return;
-            }
-        }
-    }
+    d_ptr->m_scripts.request([duration](double elapsed) {
+        return elapsed >= duration;
+    });
 }
 
 void Engine::untilLoop(const std::string& variable, const int value)
 {
-    std::vector<uint16_t> imageDataBak = d_ptr->m_vrImageData;
-
-    const std::chrono::milliseconds frameDelay(1000 / ENGINE_FPS);
-    double start = std::stod(this->getStateValue(variable));
-    double elapsed = 0.0;
-
-    auto lastTime = std::chrono::high_resolution_clock::now();
-    while (start < value) {
-        auto currentTime = std::chrono::high_resolution_clock::now();
-        double delta = std::chrono::duration<double>(currentTime - lastTime).count();
-        lastTime = currentTime;
-
-        start += delta;
-
-        d_ptr->render();
-
-        std::this_thread::sleep_for(frameDelay);
+    // Counts seconds from the current value, or stops as soon as the variable gets there
+    const int slot = getStateSlot(variable);
+    const double start = getStateNumber(slot);
 
-        // Update events
-        std::vector<EventManager::Event> events = d_ptr->m_event.getEvents();
-        for (const EventManager::Event& event : events) {
-            switch (event.type) {
-            case EventManager::Event::Type::MouseClickLeft:
-                return;
-            }
-        }
-    }
+    d_ptr->m_scripts.request([this, slot, value, start](double elapsed) {
+        return start + elapsed >= value || getStateNumber(slot) >= value;
+    });
 }
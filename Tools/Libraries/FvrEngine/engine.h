@@ -11,24 +11,100 @@
 
 #include <ofnx/files/lst.h>
 
+#include "engine/scriptbinding.h"
+
 class LIBFVRENGINE_EXPORT Engine {
 public:
-    using ScriptFunction = std::function<void(Engine& engine, std::vector<std::string> args)>;
+    using ScriptFunction = ScriptBinding::Function;
+
+    struct WarpStats {
+        double loadMs = 0.0; // VR file read and parse
+        double decodeMs = 0.0; // VR image decode
+        double waitMs = 0.0; // Waiting for a background prefetch of the same warp
+        double readyMs = 0.0; // Request to assets ready, the previous warp keeps running meanwhile
+        double totalMs = 0.0; // Request to warp entered
+
+        double animationDecodeMs = 0.0; // Animation index and frames decode
+        size_t animationBytes = 0; // Memory held by decoded animation frames and their layout
+
+        double animationMs = 0.0; // Time spent applying animation frames since warp entry
+        int animationFrameCount = 0;
+        int animationSkippedFrameCount = 0; // Never applied, out of view or overwritten by a later frame
+    };
+
+    struct CacheStats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        size_t bytes = 0;
+        size_t budget = 0;
+    };
+
+    struct LatencyStats {
+        uint64_t count = 0;
+        double lastMs = 0.0;
+        double averageMs = 0.0;
+        double maxMs = 0.0;
+    };
+
+    struct WarpCacheStats {
+        CacheStats raw; // VR file bytes
+        CacheStats decoded; // Decoded RGB565 images
+    };
+
+    struct ScriptStats {
+        size_t blockCount = 0; // Compiled script blocks
+        size_t opCount = 0;
+        size_t stringCount = 0; // Interned strings
+        size_t byteSize = 0;
+        size_t rejectedCount = 0; // Calls left out, unknown function or invalid arguments
+        double compileMs = 0.0;
+        bool isCached = false; // Read from the precompiled script image
+        double loadMs = 0.0; // Mapping the script image or parsing the text script
+        uint64_t instructionCount = 0; // Executed ops
+        double executionMs = 0.0; // Running ops and the functions they call, waits excluded
+        double instructionsPerSecond = 0.0;
+    };
+
+    struct PrefetchStats {
+        uint64_t requested = 0; // Warps queued for background loading
+        uint64_t completed = 0;
+        uint64_t cancelled = 0; // No longer reachable before being loaded
+        uint64_t dropped = 0; // Queue was full
+    };
 
 public:
     Engine();
     ~Engine();
 
-    bool init();
+    bool init(int workerCount = -1); // -1: one worker per spare CPU core
     void loop();
     void deinit();
 
+    // Typed functions get their arguments checked and converted when the script loads
+    template <auto Function>
+    void registerScriptPluginFunction(const std::string& name) { registerScriptPluginBinding(name, makeScriptBinding<Function>()); }
     void registerScriptPluginFunction(const std::string& name, const ScriptFunction& function);
+    void registerScriptPluginBinding(const std::string& name, const ScriptBinding& binding);
 
     bool isPanoramic() const;
     bool isOnZone() const;
     int pointedZone() const;
     std::vector<uint16_t>& getFrameBuffer();
+    std::vector<uint16_t>& getFrameBuffer(int x, int y, int width, int height);
+    void markFrameBufferDirty(int x, int y, int width, int height);
+    size_t getFrameDirtyBytes() const;
+    size_t getFrameUploadBytes() const;
+
+    void setRenderOnDemand(bool enabled); // Present only when something changed, wait for input when idle
+    bool isRenderOnDemand() const;
+    void setScriptProfiling(bool enabled); // Times script functions and blocks, the report is logged when disabled or on exit
+    bool isScriptProfiling() const;
+    const LatencyStats& getInputLatencyStats() const; // Mouse look or zone click to present of its result
+    ScriptStats getScriptStats() const;
+    uint64_t getPresentCount() const;
+    uint64_t getSkippedPresentCount() const;
+    double getStartupMs() const; // Loop start to the first presented frame, 0 until then
 
     void registerKeyWarp(int key, const std::string& warpName);
     void unregisterKeyWarp(int key);
@@ -39,14 +115,27 @@ public:
 
     void end();
 
-    void gotoWarp(const std::string& warpName);
+    void gotoWarp(const std::string& warpName); // Asynchronous, see isWarpLoading()
+    bool isWarpLoading() const;
+    const WarpStats& getWarpStats() const;
+
+    void setWarpCacheBudget(size_t rawBytes, size_t decodedBytes);
+    WarpCacheStats getWarpCacheStats() const;
+    PrefetchStats getPrefetchStats() const;
 
+    // Script variables are numbers, string values are kept for compatibility
     std::string getStateValue(const std::string& key);
     void setStateValue(const std::string& key, const std::string& value);
+    double getStateNumber(const std::string& key) const;
+    void setStateNumber(const std::string& key, double value);
+    int getStateSlot(const std::string& key); // Stable until the next script load
+    double getStateNumber(int slot) const;
+    void setStateNumber(int slot, double value);
 
     void setDefaultCursor(const int index, const std::string& cursor);
 
     void playAnim(const std::string& animName);
+    void playAnim(const std::string& animName, const std::string& variable, int frameCount, double speed); // frameCount <= 0 loops, speed in frames per second, variable set to 1 once over
 
     void playSound(const std::string& soundFile, uint8_t volume, bool loop = false);
     void stopSound(const std::string& soundFile);
@@ -54,6 +143,8 @@ public:
     void playMovie(const std::string& movieFile);
 
     void setAngle(const float pitch, const float yaw);
+
+    // Waits suspend the calling script block until over or skipped by a click
     void fade(int start, int end, int timer);
     void whileLoop(int timer);
     void untilLoop(const std::string& variable, const int value);
@@ -0,0 +1,87 @@
+#include "animationtimeline.h"
+
+#include <algorithm>
+#include <limits>
+
+AnimationTimeline::AnimationTimeline()
+{
+}
+
+AnimationTimeline::~AnimationTimeline()
+{
+}
+
+void AnimationTimeline::play(const std::string& name, int frameCount, double fps, const std::string& variable)
+{
+    stop(name);
+
+    Track track;
+    track.name = name;
+    track.variable = variable;
+    track.frameCount = frameCount;
+    track.fps = fps;
+    m_tracks.push_back(track);
+}
+
+void AnimationTimeline::stop(const std::string& name)
+{
+    std::erase_if(m_tracks, [&name](const Track& track) { return track.name == name; });
+}
+
+void AnimationTimeline::clear()
+{
+    m_tracks.clear();
+}
+
+std::vector<AnimationTimeline::Track> AnimationTimeline::update(double elapsedSeconds)
+{
+    std::vector<Track> finishedTracks;
+
+    for (auto it = m_tracks.begin(); it != m_tracks.end();) {
+        Track& track = *it;
+        track.clock += elapsedSeconds;
+
+        // First step is due at once, the next ones every 1/fps seconds
+        int dueSteps = (int)(track.clock * track.fps) + 1;
+        if (track.frameCount > 0) {
+            dueSteps = std::min(dueSteps, track.frameCount);
+        }
+
+        track.steps = std::max(track.steps, dueSteps);
+
+        if (track.frameCount > 0 && track.steps >= track.frameCount) {
+            finishedTracks.push_back(track);
+            it = m_tracks.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    return finishedTracks;
+}
+
+bool AnimationTimeline::isEmpty() const
+{
+    return m_tracks.empty();
+}
+
+bool AnimationTimeline::isPlaying(const std::string& name) const
+{
+    return std::ranges::any_of(m_tracks, [&name](const Track& track) { return track.name == name; });
+}
+
+double AnimationTimeline::secondsToNextStep() const
+{
+    double seconds = std::numeric_limits<double>::infinity();
+    for (const Track& track : m_tracks) {
+        // Step n is due once the clock reaches n / fps
+        seconds = std::min(seconds, std::max(0.0, track.steps / track.fps - track.clock));
+    }
+
+    return seconds;
+}
+
+const std::vector<AnimationTimeline::Track>& AnimationTimeline::tracks() const
+{
+    return m_tracks;
+}
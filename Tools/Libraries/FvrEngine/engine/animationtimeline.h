@@ -0,0 +1,42 @@
+#ifndef ENGINE_ANIMATIONTIMELINE_H
+#define ENGINE_ANIMATIONTIMELINE_H
+
+#include <string>
+#include <vector>
+
+/*
+ * Playback clocks of the animations of a warp.
+ * Each track advances at its own rate, independently of the render rate, and
+ * counts the frame steps its clock has reached.
+ */
+class AnimationTimeline {
+public:
+    struct Track {
+        std::string name;
+        std::string variable; // Set once a finite track is over
+        int frameCount = 0; // Steps to play, 0 or less loops forever
+        double fps = 0.0;
+        double clock = 0.0; // Seconds since start
+        int steps = 0; // Steps reached, the last one is the frame to show
+    };
+
+public:
+    AnimationTimeline();
+    ~AnimationTimeline();
+
+    void play(const std::string& name, int frameCount, double fps, const std::string& variable = "");
+    void stop(const std::string& name);
+    void clear();
+
+    std::vector<Track> update(double elapsedSeconds); // Returns finished tracks
+
+    bool isEmpty() const;
+    bool isPlaying(const std::string& name) const;
+    double secondsToNextStep() const; // Infinity when no track is playing
+    const std::vector<Track>& tracks() const;
+
+private:
+    std::vector<Track> m_tracks;
+};
+
+#endif // ENGINE_ANIMATIONTIMELINE_H
@@ -4,6 +4,7 @@
 
 #include <iostream>
 #include <map>
+#include <mutex>
 
 #define MINIAUDIO_IMPLEMENTATION
 #include <base/miniaudio.h>
@@ -22,6 +23,9 @@ private:
 
     ma_sound_group m_soundGroup;
     std::map<std::string, ma_sound*> m_soundList;
+
+    std::mutex m_preloadMutex;
+    std::set<std::string> m_preloadedList;
 };
 
 /* Public */
@@ -67,6 +71,8 @@ void Audio::deinit()
     }
     d_ptr->m_soundList.clear();
 
+    releasePreloadedSounds({});
+
     ma_sound_group_uninit(&d_ptr->m_soundGroup);
     ma_engine_uninit(&d_ptr->m_engine);
 
@@ -135,3 +141,39 @@ void Audio::resume()
 {
     ma_engine_start(&d_ptr->m_engine);
 }
+
+void Audio::preloadSound(const std::string& soundFile)
+{
+    std::lock_guard<std::mutex> lock(d_ptr->m_preloadMutex);
+    if (!d_ptr->m_isInit || d_ptr->m_preloadedList.contains(soundFile)) {
+        return;
+    }
+
+    const std::string file = AUDIO_DIR + soundFile;
+
+    ma_result result = ma_resource_manager_register_file(
+        ma_engine_get_resource_manager(&d_ptr->m_engine),
+        file.c_str(),
+        MA_RESOURCE_MANAGER_DATA_SOURCE_FLAG_DECODE);
+    if (result != MA_SUCCESS) {
+        return;
+    }
+
+    d_ptr->m_preloadedList.insert(soundFile);
+}
+
+void Audio::releasePreloadedSounds(const std::set<std::string>& keptFiles)
+{
+    std::lock_guard<std::mutex> lock(d_ptr->m_preloadMutex);
+
+    for (auto it = d_ptr->m_preloadedList.begin(); it != d_ptr->m_preloadedList.end();) {
+        if (keptFiles.contains(*it)) {
+            ++it;
+            continue;
+        }
+
+        const std::string file = AUDIO_DIR + *it;
+        ma_resource_manager_unregister_file(ma_engine_get_resource_manager(&d_ptr->m_engine), file.c_str());
+        it = d_ptr->m_preloadedList.erase(it);
+    }
+}
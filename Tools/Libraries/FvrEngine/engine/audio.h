@@ -2,6 +2,7 @@
 #define ENGINE_AUDIO_H
 
 #include <cstdint>
+#include <set>
 #include <string>
 
 class Audio {
@@ -16,6 +17,10 @@ public:
     void stopSound(const std::string& ambienceFile);
     bool isSoundPlaying(const std::string& ambienceFile) const;
 
+    // Thread-safe, decoded data is shared with sounds played from the same file
+    void preloadSound(const std::string& soundFile);
+    void releasePreloadedSounds(const std::set<std::string>& keptFiles);
+
     void pause();
     void resume();
 
@@ -0,0 +1,112 @@
+#include "dirtyregion.h"
+
+#include <algorithm>
+
+#define DIRTY_REGION_MAX_RECTS 16
+
+namespace {
+bool touches(const DirtyRegion::Rect& a, const DirtyRegion::Rect& b)
+{
+    return a.x <= b.x + b.width && b.x <= a.x + a.width
+        && a.y <= b.y + b.height && b.y <= a.y + a.height;
+}
+
+DirtyRegion::Rect united(const DirtyRegion::Rect& a, const DirtyRegion::Rect& b)
+{
+    const int x1 = std::min(a.x, b.x);
+    const int y1 = std::min(a.y, b.y);
+    const int x2 = std::max(a.x + a.width, b.x + b.width);
+    const int y2 = std::max(a.y + a.height, b.y + b.height);
+
+    return { x1, y1, x2 - x1, y2 - y1 };
+}
+}
+
+DirtyRegion::DirtyRegion()
+{
+}
+
+DirtyRegion::~DirtyRegion()
+{
+}
+
+void DirtyRegion::setBounds(int width, int height)
+{
+    m_width = width;
+    m_height = height;
+    m_rects.clear();
+}
+
+void DirtyRegion::add(int x, int y, int width, int height)
+{
+    // Clip to image bounds
+    const int x1 = std::max(x, 0);
+    const int y1 = std::max(y, 0);
+    const int x2 = std::min(x + width, m_width);
+    const int y2 = std::min(y + height, m_height);
+    if (x1 >= x2 || y1 >= y2) {
+        return;
+    }
+
+    Rect rect = { x1, y1, x2 - x1, y2 - y1 };
+
+    // Absorb every rectangle touching the new one (repeat as the rectangle grows)
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (auto it = m_rects.begin(); it != m_rects.end(); ++it) {
+            if (touches(rect, *it)) {
+                rect = united(rect, *it);
+                m_rects.erase(it);
+                merged = true;
+                break;
+            }
+        }
+    }
+
+    m_rects.push_back(rect);
+
+    // Too fragmented: fall back to bounding box
+    if (m_rects.size() > DIRTY_REGION_MAX_RECTS) {
+        Rect bounds = m_rects.front();
+        for (const Rect& r : m_rects) {
+            bounds = united(bounds, r);
+        }
+        m_rects = { bounds };
+    }
+}
+
+void DirtyRegion::addBlock(int pixelOffset, int blockSize)
+{
+    if (m_width <= 0) {
+        return;
+    }
+
+    add(pixelOffset % m_width, pixelOffset / m_width, blockSize, blockSize);
+}
+
+void DirtyRegion::addAll()
+{
+    m_rects.clear();
+    add(0, 0, m_width, m_height);
+}
+
+void DirtyRegion::clear()
+{
+    m_rects.clear();
+}
+
+bool DirtyRegion::isEmpty() const
+{
+    return m_rects.empty();
+}
+
+size_t DirtyRegion::area() const
+{
+    size_t total = 0;
+    for (const Rect& rect : m_rects) {
+        total += (size_t)rect.width * rect.height;
+    }
+
+    return total;
+}
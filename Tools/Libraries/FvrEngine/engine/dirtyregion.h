@@ -0,0 +1,41 @@
+#ifndef ENGINE_DIRTYREGION_H
+#define ENGINE_DIRTYREGION_H
+
+#include <cstddef>
+#include <vector>
+
+/*
+ * Set of modified rectangles inside an image.
+ * Overlapping or touching rectangles are merged, and the region collapses to
+ * its bounding box when too many disjoint rectangles accumulate.
+ */
+class DirtyRegion {
+public:
+    struct Rect {
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+    };
+
+public:
+    DirtyRegion();
+    ~DirtyRegion();
+
+    void setBounds(int width, int height);
+
+    void add(int x, int y, int width, int height);
+    void addBlock(int pixelOffset, int blockSize = 8);
+    void addAll();
+    void clear();
+
+    bool isEmpty() const;
+    size_t area() const;
+
+private:
+    int m_width = 0;
+    int m_height = 0;
+    std::vector<Rect> m_rects;
+};
+
+#endif // ENGINE_DIRTYREGION_H
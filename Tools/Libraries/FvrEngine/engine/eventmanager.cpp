@@ -25,6 +25,8 @@ std::vector<EventManager::Event> EventManager::getEvents()
 
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
+        const auto eventCount = eventList.size();
+
         if (event.type == SDL_EVENT_QUIT) {
             eventList.push_back({ Event::Quit });
         } else if (event.type == SDL_EVENT_KEY_DOWN) {
@@ -32,6 +34,8 @@ std::vector<EventManager::Event> EventManager::getEvents()
                 eventList.push_back({ Event::Quit });
             } else if (event.key.key == SDLK_RETURN) {
                 eventList.push_back({ Event::MainMenu });
+            } else if (event.key.key == SDLK_F9) {
+                eventList.push_back({ Event::ToggleScriptProfiling });
             }
         } else if (event.type == SDL_EVENT_MOUSE_MOTION) {
             eventList.push_back(Event { Event::MouseMove, event.motion.x, event.motion.y, event.motion.xrel, event.motion.yrel });
@@ -43,8 +47,19 @@ std::vector<EventManager::Event> EventManager::getEvents()
             }
         } else if (event.type == SDL_EVENT_MOUSE_WHEEL) {
             eventList.push_back({ Event::MouseWheel, event.wheel.x, event.wheel.y });
+        } else if (event.type == SDL_EVENT_WINDOW_EXPOSED || event.type == SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED || event.type == SDL_EVENT_WINDOW_RESTORED) {
+            eventList.push_back({ Event::WindowChanged });
+        }
+
+        if (eventList.size() > eventCount) {
+            eventList.back().timestampNs = event.common.timestamp ? event.common.timestamp : SDL_GetTicksNS();
         }
     }
 
     return eventList;
 }
+
+bool EventManager::waitEvents(int timeoutMs)
+{
+    return SDL_WaitEventTimeout(nullptr, timeoutMs);
+}
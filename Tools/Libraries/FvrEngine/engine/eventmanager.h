@@ -1,6 +1,7 @@
 #ifndef ENGINE_EVENTMANAGER_H
 #define ENGINE_EVENTMANAGER_H
 
+#include <cstdint>
 #include <vector>
 
 class EventManager {
@@ -13,6 +14,8 @@ public:
             MouseClickRight,
             MouseMove,
             MouseWheel,
+            WindowChanged, // Window content must be redrawn
+            ToggleScriptProfiling,
         };
 
         Type type;
@@ -20,6 +23,7 @@ public:
         float y = 0;
         float xRel = 0;
         float yRel = 0;
+        uint64_t timestampNs = 0; // SDL_GetTicksNS() time the event was queued
     };
 
 public:
@@ -30,6 +34,7 @@ public:
     void deinit();
 
     std::vector<Event> getEvents();
+    bool waitEvents(int timeoutMs); // True if events are pending, they are left in the queue
 };
 
 #endif // ENGINE_EVENTMANAGER_H
@@ -0,0 +1,162 @@
+#include "prefetcher.h"
+
+#include <algorithm>
+#include <exception>
+
+#include <ofnx/tools/log.h>
+
+#include "threadpool.h"
+
+Prefetcher::Prefetcher()
+{
+}
+
+Prefetcher::~Prefetcher()
+{
+    deinit();
+}
+
+bool Prefetcher::init(ThreadPool* pool, const Job& job, int maxQueued, int maxRunning)
+{
+    deinit();
+
+    // Jobs would run inline and block the caller, no running slot turns prefetching off
+    if (!pool || pool->workerCount() == 0 || maxRunning <= 0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pool = pool;
+    m_job = job;
+    m_maxQueued = maxQueued;
+    m_maxRunning = maxRunning;
+    m_isEnabled = true;
+
+    return true;
+}
+
+void Prefetcher::deinit()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_isEnabled = false;
+    m_stats.cancelled += m_queue.size();
+    m_queue.clear();
+
+    // Wait for running jobs
+    m_condition.wait(lock, [this]() { return m_running == 0; });
+}
+
+void Prefetcher::request(const std::vector<std::string>& names)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_isEnabled) {
+            return;
+        }
+
+        // Cancel jobs that are no longer wanted
+        const size_t queued = m_queue.size();
+        std::erase_if(m_queue, [&names](const std::string& name) {
+            return std::find(names.begin(), names.end(), name) == names.end();
+        });
+        m_stats.cancelled += queued - m_queue.size();
+
+        for (const std::string& name : names) {
+            if (m_inFlight.contains(name) || std::find(m_queue.begin(), m_queue.end(), name) != m_queue.end()) {
+                continue;
+            }
+
+            if ((int)m_queue.size() >= m_maxQueued) {
+                m_stats.dropped++;
+                continue;
+            }
+
+            m_queue.push_back(name);
+            m_stats.requested++;
+        }
+    }
+
+    submitRunners();
+}
+
+bool Prefetcher::claim(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Caller loads it itself
+    const size_t queued = m_queue.size();
+    std::erase(m_queue, name);
+    m_stats.cancelled += queued - m_queue.size();
+
+    // Or retries once the running job is over
+    return !m_inFlight.contains(name);
+}
+
+bool Prefetcher::isEnabled() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_isEnabled;
+}
+
+Prefetcher::Stats Prefetcher::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void Prefetcher::submitRunners()
+{
+    int toSubmit = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        while (m_running + toSubmit < m_maxRunning && toSubmit < (int)m_queue.size()) {
+            toSubmit++;
+        }
+        m_running += toSubmit;
+    }
+
+    for (int i = 0; i < toSubmit; i++) {
+        m_pool->submit([this]() { runNext(); });
+    }
+}
+
+void Prefetcher::runNext()
+{
+    std::string name;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_queue.empty() || !m_isEnabled) {
+            m_running--;
+            m_condition.notify_all();
+            return;
+        }
+
+        name = m_queue.front();
+        m_queue.pop_front();
+        m_inFlight.insert(name);
+    }
+
+    // The name must leave m_inFlight whatever happens, or its warp could never load
+    try {
+        m_job(name);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Failed to prefetch {}: {}", name, e.what());
+    } catch (...) {
+        LOG_ERROR("Failed to prefetch {}", name);
+    }
+
+    // One job per pool task so other pool users are not starved
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_inFlight.erase(name);
+        m_stats.completed++;
+
+        if (m_queue.empty() || !m_isEnabled) {
+            m_running--;
+            m_condition.notify_all();
+            return;
+        }
+    }
+
+    m_pool->submit([this]() { runNext(); });
+}
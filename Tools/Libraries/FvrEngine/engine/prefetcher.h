@@ -0,0 +1,63 @@
+#ifndef ENGINE_PREFETCHER_H
+#define ENGINE_PREFETCHER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+/*
+ * Bounded queue of named background jobs run on a thread pool.
+ * Each request replaces the wanted set: queued jobs that are no longer
+ * wanted are cancelled, jobs already running are left to complete.
+ */
+class Prefetcher {
+public:
+    using Job = std::function<void(const std::string& name)>;
+
+    struct Stats {
+        uint64_t requested = 0;
+        uint64_t completed = 0;
+        uint64_t cancelled = 0;
+        uint64_t dropped = 0; // Queue was full
+    };
+
+public:
+    Prefetcher();
+    ~Prefetcher();
+
+    bool init(ThreadPool* pool, const Job& job, int maxQueued, int maxRunning); // False and disabled when maxRunning is 0
+    void deinit();
+    bool isEnabled() const;
+
+    void request(const std::vector<std::string>& names);
+    bool claim(const std::string& name); // False while a job for this name is running
+
+    Stats stats() const;
+
+private:
+    void submitRunners();
+    void runNext();
+
+private:
+    ThreadPool* m_pool = nullptr;
+    Job m_job;
+    int m_maxQueued = 0;
+    int m_maxRunning = 0;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<std::string> m_queue;
+    std::set<std::string> m_inFlight;
+    int m_running = 0;
+    bool m_isEnabled = false;
+    Stats m_stats;
+};
+
+#endif // ENGINE_PREFETCHER_H
@@ -0,0 +1,196 @@
+#ifndef ENGINE_SCRIPTBINDING_H
+#define ENGINE_SCRIPTBINDING_H
+
+#include <cctype>
+#include <charconv>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class Engine;
+
+/*
+ * Script function called with arguments converted once, when the script is
+ * compiled. Argument count and type errors are reported at that time.
+ */
+struct ScriptBinding {
+    using Function = std::function<void(Engine& engine, std::vector<std::string> args)>; // Raw arguments, not checked
+    using Arguments = std::shared_ptr<const void>;
+
+    std::function<Arguments(const std::vector<std::string>& params, std::string& error)> bind; // Null on error
+    void (*call)(Engine& engine, const void* arguments) = nullptr;
+};
+
+namespace scriptbinding {
+
+template <typename T>
+struct Parameter;
+
+template <>
+struct Parameter<double> {
+    static constexpr const char* typeName = "number";
+    static bool parse(const std::string& param, double& value)
+    {
+        // Spaces around the number and a leading '+' are read like std::stod does
+        const char* first = param.data();
+        const char* last = first + param.size();
+        while (first < last && std::isspace((unsigned char)*first)) {
+            first++;
+        }
+        while (last > first && std::isspace((unsigned char)last[-1])) {
+            last--;
+        }
+        if (last - first > 1 && first[0] == '+' && first[1] != '-') {
+            first++;
+        }
+
+        const auto result = std::from_chars(first, last, value);
+        return first < last && result.ec == std::errc() && result.ptr == last;
+    }
+};
+
+template <>
+struct Parameter<float> {
+    static constexpr const char* typeName = "number";
+    static bool parse(const std::string& param, float& value)
+    {
+        double number = 0.0;
+        if (!Parameter<double>::parse(param, number)) {
+            return false;
+        }
+        value = (float)number;
+        return true;
+    }
+};
+
+template <>
+struct Parameter<int> {
+    static constexpr const char* typeName = "number";
+    static bool parse(const std::string& param, int& value)
+    {
+        // Scripts write integers as decimals too
+        double number = 0.0;
+        if (!Parameter<double>::parse(param, number)) {
+            return false;
+        }
+        value = (int)number;
+        return true;
+    }
+};
+
+template <>
+struct Parameter<bool> {
+    static constexpr const char* typeName = "number";
+    static bool parse(const std::string& param, bool& value)
+    {
+        double number = 0.0;
+        if (!Parameter<double>::parse(param, number)) {
+            return false;
+        }
+        value = number != 0.0;
+        return true;
+    }
+};
+
+template <>
+struct Parameter<std::string> {
+    static constexpr const char* typeName = "string";
+    static bool parse(const std::string& param, std::string& value)
+    {
+        value = param;
+        return true;
+    }
+};
+
+// Converted value kept for the call, views point into it
+template <typename T>
+struct Storage {
+    using Type = T;
+};
+
+template <>
+struct Storage<std::string_view> {
+    using Type = std::string;
+};
+
+template <typename Signature>
+struct Traits;
+
+template <typename... Args>
+struct Traits<void (*)(Engine&, Args...)> {
+    using Tuple = std::tuple<typename Storage<std::decay_t<Args>>::Type...>;
+    static constexpr size_t arity = sizeof...(Args);
+};
+
+template <typename Tuple, size_t... Indices>
+bool parseAll(const std::vector<std::string>& params, Tuple& values, std::string& error, std::index_sequence<Indices...>)
+{
+    [[maybe_unused]] const auto parseOne = [&params, &error](auto& value, size_t index) {
+        using Type = std::decay_t<decltype(value)>;
+        if (Parameter<Type>::parse(params[index], value)) {
+            return true;
+        }
+        error = "argument " + std::to_string(index + 1) + " is not a " + Parameter<Type>::typeName + ": " + params[index];
+        return false;
+    };
+
+    return (parseOne(std::get<Indices>(values), Indices) && ...);
+}
+
+} // namespace scriptbinding
+
+// Binds a function taking the engine followed by typed parameters
+template <auto Function>
+ScriptBinding makeScriptBinding()
+{
+    using Traits = scriptbinding::Traits<decltype(Function)>;
+    using Tuple = typename Traits::Tuple;
+
+    ScriptBinding binding;
+    binding.bind = [](const std::vector<std::string>& params, std::string& error) -> ScriptBinding::Arguments {
+        if (params.size() != Traits::arity) {
+            error = "expects " + std::to_string(Traits::arity) + " arguments, got " + std::to_string(params.size());
+            return nullptr;
+        }
+
+        std::shared_ptr<Tuple> values = std::make_shared<Tuple>();
+        if (!scriptbinding::parseAll(params, *values, error, std::make_index_sequence<Traits::arity>())) {
+            return nullptr;
+        }
+
+        return values;
+    };
+    binding.call = [](Engine& engine, const void* arguments) {
+        std::apply([&engine](const auto&... values) { Function(engine, values...); }, *static_cast<const Tuple*>(arguments));
+    };
+
+    return binding;
+}
+
+// Binds a function parsing its raw arguments itself
+inline ScriptBinding makeScriptBinding(const ScriptBinding::Function& function)
+{
+    struct Call {
+        ScriptBinding::Function function;
+        std::vector<std::string> params;
+    };
+
+    ScriptBinding binding;
+    binding.bind = [function](const std::vector<std::string>& params, std::string&) -> ScriptBinding::Arguments {
+        return std::make_shared<Call>(Call { function, params });
+    };
+    binding.call = [](Engine& engine, const void* arguments) {
+        const Call* call = static_cast<const Call*>(arguments);
+        call->function(engine, call->params);
+    };
+
+    return binding;
+}
+
+#endif // ENGINE_SCRIPTBINDING_H
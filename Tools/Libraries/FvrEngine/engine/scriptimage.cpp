@@ -0,0 +1,639 @@
+#include "scriptimage.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+#include "scriptbinding.h"
+#include "warpname.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* Constants */
+#define SCRIPT_IMAGE_MAGIC "FVRS"
+#define SCRIPT_IMAGE_EXTENSION ".lsi"
+#define SCRIPT_IMAGE_HASH_OFFSET 14695981039346656037ull // FNV-1a
+#define SCRIPT_IMAGE_HASH_PRIME 1099511628211ull
+
+namespace {
+
+// Offsets are in bytes from the start of the file, counts in records
+struct Section {
+    uint32_t offset = 0;
+    uint32_t count = 0;
+};
+
+struct Header {
+    char magic[4];
+    uint32_t version = 0;
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+    uint64_t sourceWarps = 0;
+    Section stringOffsets; // String count + 1 entries
+    Section stringData; // Bytes
+    Section instructions;
+    Section params;
+    Section blocks;
+    Section variables;
+    Section warps;
+    Section zones;
+};
+
+class Builder {
+public:
+    Builder(ofnx::files::Lst& script, const ScriptImage::ZoneCounter& zoneCounter)
+        : m_script(script)
+        , m_zoneCounter(zoneCounter)
+    {
+        // Empty block first, instructions without sub instructions point to it
+        m_blocks.push_back({});
+    }
+
+    // Records of the image are kept with their ids, new ones come after them
+    void addImage(const ScriptImage& image)
+    {
+        m_strings.clear();
+        m_stringIds.clear();
+        for (uint32_t i = 0; i < image.stringCount(); i++) {
+            m_strings.emplace_back(image.string(i));
+            m_stringIds.emplace(m_strings.back(), i);
+        }
+
+        m_instructions.clear();
+        for (uint32_t i = 0; i < image.instructionCount(); i++) {
+            m_instructions.push_back(image.instruction(i));
+        }
+
+        m_params.clear();
+        for (uint32_t i = 0; i < image.paramCount(); i++) {
+            m_params.push_back(image.param(i));
+        }
+
+        m_blocks.clear();
+        for (uint32_t i = 0; i < image.blockCount(); i++) {
+            m_blocks.push_back(image.block(i));
+        }
+
+        m_variables.clear();
+        for (uint32_t i = 0; i < image.variableCount(); i++) {
+            m_variables.push_back(image.variable(i));
+        }
+
+        m_warps.clear();
+        m_warpNames.clear();
+        for (uint32_t i = 0; i < image.warpCount(); i++) {
+            m_warps.push_back(image.warp(i));
+            m_warpNames.insert(normalizeWarpName(std::string(image.string(image.warp(i).name))));
+        }
+
+        m_zones.clear();
+        for (uint32_t i = 0; i < image.zoneCount(); i++) {
+            m_zones.push_back(image.zoneBlock(i));
+        }
+    }
+
+    void addWarp(const std::string& warpName)
+    {
+        if (!m_warpNames.insert(normalizeWarpName(warpName)).second) {
+            return;
+        }
+
+        ScriptImage::Warp warp;
+        std::vector<uint32_t> zones;
+        try {
+            warp.initBlock = addTopBlock(m_script.getInitBlock(warpName));
+            const int zoneCount = m_zoneCounter ? m_zoneCounter(warpName) : 0;
+            for (int zone = 0; zone < zoneCount; zone++) {
+                zones.push_back(addTopBlock(m_script.getTestBlock(warpName, zone)));
+            }
+        } catch (const std::exception&) {
+            // Referenced but not in the script
+            return;
+        }
+
+        warp.name = intern(warpName);
+        warp.firstZone = (uint32_t)m_zones.size();
+        warp.zoneCount = (uint32_t)zones.size();
+        m_zones.insert(m_zones.end(), zones.begin(), zones.end());
+        m_warps.push_back(warp);
+
+        // Warps this one leads to
+        std::vector<std::string> targets;
+        collectTargets(warp.initBlock, targets);
+        for (uint32_t zone : zones) {
+            collectTargets(zone, targets);
+        }
+        for (const std::string& target : targets) {
+            addWarp(target);
+        }
+    }
+
+    void addVariables(const std::vector<std::string>& variables)
+    {
+        for (const std::string& variable : variables) {
+            m_variables.push_back(intern(variable));
+        }
+    }
+
+    size_t warpCount() const
+    {
+        return m_warps.size();
+    }
+
+    std::vector<uint8_t> write(const ScriptImage::Source& source) const
+    {
+        std::vector<uint32_t> stringOffsets = { 0 };
+        std::string stringData;
+        for (const std::string& value : m_strings) {
+            stringData += value;
+            stringOffsets.push_back((uint32_t)stringData.size());
+        }
+
+        Header header;
+        std::memcpy(header.magic, SCRIPT_IMAGE_MAGIC, sizeof(header.magic));
+        header.version = ScriptImage::Version;
+        header.sourceSize = source.size;
+        header.sourceTime = source.time;
+        header.sourceWarps = source.warps;
+
+        std::vector<uint8_t> data(sizeof(Header));
+        const auto append = [&data](Section& section, const void* values, size_t count, size_t recordSize) {
+            // Records stay 4 bytes aligned
+            data.resize((data.size() + 3) & ~size_t(3));
+            section.offset = (uint32_t)data.size();
+            section.count = (uint32_t)count;
+            const size_t size = count * recordSize;
+            data.resize(data.size() + size);
+            if (size > 0) {
+                std::memcpy(data.data() + section.offset, values, size);
+            }
+        };
+
+        append(header.stringOffsets, stringOffsets.data(), stringOffsets.size(), sizeof(uint32_t));
+        append(header.stringData, stringData.data(), stringData.size(), 1);
+        append(header.instructions, m_instructions.data(), m_instructions.size(), sizeof(ScriptImage::Instruction));
+        append(header.params, m_params.data(), m_params.size(), sizeof(uint32_t));
+        append(header.blocks, m_blocks.data(), m_blocks.size(), sizeof(ScriptImage::Block));
+        append(header.variables, m_variables.data(), m_variables.size(), sizeof(uint32_t));
+        append(header.warps, m_warps.data(), m_warps.size(), sizeof(ScriptImage::Warp));
+        append(header.zones, m_zones.data(), m_zones.size(), sizeof(uint32_t));
+
+        std::memcpy(data.data(), &header, sizeof(Header));
+
+        return data;
+    }
+
+private:
+    uint32_t addTopBlock(const ofnx::files::Lst::InstructionBlock& block)
+    {
+        // Zones without script may share the same block
+        auto it = m_topBlocks.find(&block);
+        if (it != m_topBlocks.end()) {
+            return it->second;
+        }
+
+        const uint32_t id = addBlock(block);
+        m_topBlocks[&block] = id;
+
+        return id;
+    }
+
+    uint32_t addBlock(const ofnx::files::Lst::InstructionBlock& block)
+    {
+        if (block.empty()) {
+            return ScriptImage::EmptyBlock;
+        }
+
+        // Instructions of a block are contiguous, sub blocks come after it
+        const uint32_t id = (uint32_t)m_blocks.size();
+        const uint32_t first = (uint32_t)m_instructions.size();
+        m_blocks.push_back({ first, (uint32_t)block.size() });
+        m_instructions.resize(m_instructions.size() + block.size());
+
+        for (size_t i = 0; i < block.size(); i++) {
+            const ofnx::files::Lst::Instruction& instruction = block[i];
+
+            ScriptImage::Instruction record;
+            record.name = intern(instruction.name);
+            record.firstParam = (uint32_t)m_params.size();
+            record.paramCount = (uint32_t)instruction.params.size();
+            for (const std::string& param : instruction.params) {
+                m_params.push_back(intern(param));
+            }
+            record.block = addBlock(instruction.subInstructions);
+
+            m_instructions[first + i] = record;
+        }
+
+        return id;
+    }
+
+    void collectTargets(uint32_t blockId, std::vector<std::string>& targets) const
+    {
+        const ScriptImage::Block& block = m_blocks[blockId];
+        for (uint32_t i = block.firstInstruction; i < block.firstInstruction + block.instructionCount; i++) {
+            const ScriptImage::Instruction& instruction = m_instructions[i];
+            const std::string& name = m_strings[instruction.name];
+
+            if (name == "gotowarp" && instruction.paramCount == 1) {
+                targets.push_back(m_strings[m_params[instruction.firstParam]]);
+            } else if (name == "lockkey" && instruction.paramCount == 2) {
+                // Numeric target unregisters the key
+                std::string target = m_strings[m_params[instruction.firstParam + 1]];
+                double number = 0.0;
+                if (!scriptbinding::Parameter<double>::parse(target, number)) {
+                    std::transform(target.begin(), target.end(), target.begin(), ::tolower);
+                    targets.push_back(target);
+                }
+            }
+
+            if (instruction.block != ScriptImage::EmptyBlock) {
+                collectTargets(instruction.block, targets);
+            }
+        }
+    }
+
+    uint32_t intern(const std::string& value)
+    {
+        auto it = m_stringIds.find(value);
+        if (it != m_stringIds.end()) {
+            return it->second;
+        }
+
+        const uint32_t id = (uint32_t)m_strings.size();
+        m_strings.push_back(value);
+        m_stringIds[value] = id;
+
+        return id;
+    }
+
+private:
+    ofnx::files::Lst& m_script;
+    const ScriptImage::ZoneCounter& m_zoneCounter;
+
+    std::vector<std::string> m_strings;
+    std::unordered_map<std::string, uint32_t> m_stringIds;
+    std::vector<ScriptImage::Instruction> m_instructions;
+    std::vector<uint32_t> m_params;
+    std::vector<ScriptImage::Block> m_blocks;
+    std::vector<uint32_t> m_variables;
+    std::vector<ScriptImage::Warp> m_warps;
+    std::vector<uint32_t> m_zones;
+    std::map<const ofnx::files::Lst::InstructionBlock*, uint32_t> m_topBlocks;
+    std::set<std::string> m_warpNames;
+};
+
+} // namespace
+
+struct ScriptImage::Mapping {
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+    void* data = nullptr;
+    size_t size = 0;
+};
+
+ScriptImage::ScriptImage()
+{
+}
+
+ScriptImage::~ScriptImage()
+{
+    close();
+}
+
+std::vector<uint8_t> ScriptImage::build(ofnx::files::Lst& script, const std::vector<std::string>& warpNames, const ZoneCounter& zoneCounter, const Source& source)
+{
+    Builder builder(script, zoneCounter);
+    builder.addVariables(script.getVariables());
+    for (const std::string& warpName : warpNames) {
+        builder.addWarp(warpName);
+    }
+
+    return builder.write(source);
+}
+
+std::vector<uint8_t> ScriptImage::extend(ofnx::files::Lst& script, const ScriptImage& base, const std::string& warpName, const ZoneCounter& zoneCounter)
+{
+    Builder builder(script, zoneCounter);
+    builder.addImage(base);
+    const size_t warpCount = builder.warpCount();
+    builder.addWarp(warpName);
+    if (builder.warpCount() == warpCount) {
+        return {};
+    }
+
+    return builder.write(base.source());
+}
+
+bool ScriptImage::save(const std::string& path, const std::vector<uint8_t>& data)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.write(reinterpret_cast<const char*>(data.data()), data.size())) {
+        return false;
+    }
+
+    return true;
+}
+
+ScriptImage::Source ScriptImage::sourceOf(const std::string& scriptFile, const std::vector<std::string>& warpNames, const ZoneCounter& zoneCounter)
+{
+    std::error_code error;
+    Source source;
+    source.size = std::filesystem::file_size(scriptFile, error);
+    if (error) {
+        return {};
+    }
+    source.time = std::filesystem::last_write_time(scriptFile, error).time_since_epoch().count();
+    if (error) {
+        return {};
+    }
+
+    // Adding a warp or changing its zones changes the image as much as editing the script
+    std::vector<std::pair<std::string, const std::string*>> names; // Files are read by their own name
+    for (const std::string& warpName : warpNames) {
+        names.emplace_back(normalizeWarpName(warpName), &warpName);
+    }
+    std::sort(names.begin(), names.end());
+
+    uint64_t hash = SCRIPT_IMAGE_HASH_OFFSET;
+    const auto add = [&hash](const void* data, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ static_cast<const uint8_t*>(data)[i]) * SCRIPT_IMAGE_HASH_PRIME;
+        }
+    };
+    for (const auto& [name, warpName] : names) {
+        const int32_t zoneCount = zoneCounter ? zoneCounter(*warpName) : 0;
+        add(name.c_str(), name.size() + 1);
+        add(&zoneCount, sizeof(zoneCount));
+    }
+    source.warps = hash;
+
+    return source;
+}
+
+std::string ScriptImage::imagePath(const std::string& scriptFile)
+{
+    return std::filesystem::path(scriptFile).replace_extension(SCRIPT_IMAGE_EXTENSION).string();
+}
+
+bool ScriptImage::open(const std::string& path)
+{
+    close();
+
+    Mapping* mapping = new Mapping();
+
+#ifdef _WIN32
+    mapping->file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER fileSize;
+    if (mapping->file == INVALID_HANDLE_VALUE || !GetFileSizeEx(mapping->file, &fileSize) || fileSize.QuadPart == 0) {
+        if (mapping->file != INVALID_HANDLE_VALUE) {
+            CloseHandle(mapping->file);
+        }
+        delete mapping;
+        return false;
+    }
+    mapping->size = (size_t)fileSize.QuadPart;
+
+    mapping->mapping = CreateFileMappingA(mapping->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping->mapping) {
+        mapping->data = MapViewOfFile(mapping->mapping, FILE_MAP_READ, 0, 0, 0);
+    }
+    if (!mapping->data) {
+        if (mapping->mapping) {
+            CloseHandle(mapping->mapping);
+        }
+        CloseHandle(mapping->file);
+        delete mapping;
+        return false;
+    }
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    struct stat status;
+    if (fd < 0 || fstat(fd, &status) != 0 || status.st_size == 0) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        delete mapping;
+        return false;
+    }
+    mapping->size = (size_t)status.st_size;
+
+    // The mapping stays valid once the descriptor is closed
+    mapping->data = mmap(nullptr, mapping->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping->data == MAP_FAILED) {
+        delete mapping;
+        return false;
+    }
+#endif
+
+    m_mapping = mapping;
+    m_data = static_cast<const uint8_t*>(mapping->data);
+    m_size = mapping->size;
+
+    if (!bind()) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool ScriptImage::load(std::vector<uint8_t> data)
+{
+    close();
+
+    m_buffer = std::move(data);
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+
+    if (!bind()) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void ScriptImage::close()
+{
+    if (m_mapping) {
+#ifdef _WIN32
+        UnmapViewOfFile(m_mapping->data);
+        CloseHandle(m_mapping->mapping);
+        CloseHandle(m_mapping->file);
+#else
+        munmap(m_mapping->data, m_mapping->size);
+#endif
+        delete m_mapping;
+        m_mapping = nullptr;
+    }
+
+    m_buffer.clear();
+    m_data = nullptr;
+    m_size = 0;
+    m_source = {};
+    m_stringCount = 0;
+    m_instructionCount = 0;
+    m_paramCount = 0;
+    m_blockCount = 0;
+    m_variableCount = 0;
+    m_warpCount = 0;
+    m_zoneCount = 0;
+}
+
+void ScriptImage::swap(ScriptImage& other)
+{
+    // Tables point into the mapping or the buffer, both move with them
+    std::swap(m_mapping, other.m_mapping);
+    m_buffer.swap(other.m_buffer);
+    std::swap(m_data, other.m_data);
+    std::swap(m_size, other.m_size);
+    std::swap(m_source, other.m_source);
+    std::swap(m_stringOffsets, other.m_stringOffsets);
+    std::swap(m_stringData, other.m_stringData);
+    std::swap(m_instructions, other.m_instructions);
+    std::swap(m_params, other.m_params);
+    std::swap(m_blocks, other.m_blocks);
+    std::swap(m_variables, other.m_variables);
+    std::swap(m_warps, other.m_warps);
+    std::swap(m_zones, other.m_zones);
+    std::swap(m_stringCount, other.m_stringCount);
+    std::swap(m_instructionCount, other.m_instructionCount);
+    std::swap(m_paramCount, other.m_paramCount);
+    std::swap(m_blockCount, other.m_blockCount);
+    std::swap(m_variableCount, other.m_variableCount);
+    std::swap(m_warpCount, other.m_warpCount);
+    std::swap(m_zoneCount, other.m_zoneCount);
+}
+
+std::string_view ScriptImage::string(uint32_t id) const
+{
+    return std::string_view(m_stringData + m_stringOffsets[id], m_stringOffsets[id + 1] - m_stringOffsets[id]);
+}
+
+std::vector<std::string> ScriptImage::params(const Instruction& instruction) const
+{
+    std::vector<std::string> values;
+    values.reserve(instruction.paramCount);
+    for (uint32_t i = 0; i < instruction.paramCount; i++) {
+        values.emplace_back(string(m_params[instruction.firstParam + i]));
+    }
+
+    return values;
+}
+
+bool ScriptImage::bind()
+{
+    if (m_size < sizeof(Header)) {
+        return false;
+    }
+
+    Header header;
+    std::memcpy(&header, m_data, sizeof(Header));
+    if (std::memcmp(header.magic, SCRIPT_IMAGE_MAGIC, sizeof(header.magic)) != 0 || header.version != Version) {
+        return false;
+    }
+
+    // Tables are read in place, only their bounds are checked
+    const auto table = [this](const Section& section, size_t recordSize) -> const void* {
+        if (section.offset % 4 != 0 || (uint64_t)section.offset + (uint64_t)section.count * recordSize > m_size) {
+            return nullptr;
+        }
+        return m_data + section.offset;
+    };
+
+    m_stringOffsets = static_cast<const uint32_t*>(table(header.stringOffsets, sizeof(uint32_t)));
+    m_stringData = static_cast<const char*>(table(header.stringData, 1));
+    m_instructions = static_cast<const Instruction*>(table(header.instructions, sizeof(Instruction)));
+    m_params = static_cast<const uint32_t*>(table(header.params, sizeof(uint32_t)));
+    m_blocks = static_cast<const Block*>(table(header.blocks, sizeof(Block)));
+    m_variables = static_cast<const uint32_t*>(table(header.variables, sizeof(uint32_t)));
+    m_warps = static_cast<const Warp*>(table(header.warps, sizeof(Warp)));
+    m_zones = static_cast<const uint32_t*>(table(header.zones, sizeof(uint32_t)));
+    if (!m_stringOffsets || !m_stringData || !m_instructions || !m_params || !m_blocks || !m_variables || !m_warps || !m_zones
+        || header.stringOffsets.count == 0 || header.blocks.count == 0) {
+        return false;
+    }
+
+    m_stringCount = header.stringOffsets.count - 1;
+    m_instructionCount = header.instructions.count;
+    m_paramCount = header.params.count;
+    m_blockCount = header.blocks.count;
+    m_variableCount = header.variables.count;
+    m_warpCount = header.warps.count;
+    m_zoneCount = header.zones.count;
+
+    for (uint32_t i = 0; i < m_stringCount; i++) {
+        if (m_stringOffsets[i] > m_stringOffsets[i + 1]) {
+            return false;
+        }
+    }
+    if (m_stringOffsets[m_stringCount] > header.stringData.count) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < header.params.count; i++) {
+        if (m_params[i] >= m_stringCount) {
+            return false;
+        }
+    }
+
+    // Sub blocks come after their parent, so running a block always ends
+    for (uint32_t id = 0; id < m_blockCount; id++) {
+        const Block& block = m_blocks[id];
+        if ((uint64_t)block.firstInstruction + block.instructionCount > header.instructions.count) {
+            return false;
+        }
+
+        for (uint32_t i = block.firstInstruction; i < block.firstInstruction + block.instructionCount; i++) {
+            const Instruction& instruction = m_instructions[i];
+            if (instruction.name >= m_stringCount
+                || (uint64_t)instruction.firstParam + instruction.paramCount > header.params.count
+                || instruction.block >= m_blockCount
+                || (instruction.block != EmptyBlock && instruction.block <= id)) {
+                return false;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < m_variableCount; i++) {
+        if (m_variables[i] >= m_stringCount) {
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < m_warpCount; i++) {
+        const Warp& warp = m_warps[i];
+        if (warp.name >= m_stringCount || warp.initBlock >= m_blockCount || (uint64_t)warp.firstZone + warp.zoneCount > header.zones.count) {
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < header.zones.count; i++) {
+        if (m_zones[i] >= m_blockCount) {
+            return false;
+        }
+    }
+
+    m_source.size = header.sourceSize;
+    m_source.time = header.sourceTime;
+    m_source.warps = header.sourceWarps;
+
+    return true;
+}
@@ -0,0 +1,124 @@
+#ifndef ENGINE_SCRIPTIMAGE_H
+#define ENGINE_SCRIPTIMAGE_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <ofnx/files/lst.h>
+
+/*
+ * Precompiled LST script, flattened to tables of fixed size records.
+ * The file is memory-mapped and read in place, the text script is only
+ * parsed when the image is missing or older than it.
+ */
+class ScriptImage {
+public:
+    static constexpr uint32_t Version = 2;
+    static constexpr uint32_t EmptyBlock = 0; // Always present
+
+    struct Instruction {
+        uint32_t name = 0; // String id
+        uint32_t firstParam = 0;
+        uint32_t paramCount = 0;
+        uint32_t block = EmptyBlock; // Sub instructions
+    };
+
+    struct Block {
+        uint32_t firstInstruction = 0;
+        uint32_t instructionCount = 0;
+    };
+
+    struct Warp {
+        uint32_t name = 0; // String id
+        uint32_t initBlock = EmptyBlock;
+        uint32_t firstZone = 0;
+        uint32_t zoneCount = 0;
+    };
+
+    // Text script and warp files the image was built from
+    struct Source {
+        uint64_t size = 0;
+        int64_t time = 0;
+        uint64_t warps = 0; // Hash of the warp names and zone counts
+
+        bool operator==(const Source& other) const = default;
+    };
+
+    using ZoneCounter = std::function<int(const std::string& warpName)>;
+
+public:
+    ScriptImage();
+    ~ScriptImage();
+
+    ScriptImage(const ScriptImage&) = delete;
+    ScriptImage& operator=(const ScriptImage&) = delete;
+
+    // Warps reached from the given ones by gotowarp and lockkey are added too
+    static std::vector<uint8_t> build(ofnx::files::Lst& script, const std::vector<std::string>& warpNames, const ZoneCounter& zoneCounter, const Source& source);
+    // Base image followed by a warp missing from it, base ids stay valid. Empty when the script does not have the warp
+    static std::vector<uint8_t> extend(ofnx::files::Lst& script, const ScriptImage& base, const std::string& warpName, const ZoneCounter& zoneCounter);
+    static bool save(const std::string& path, const std::vector<uint8_t>& data);
+    static Source sourceOf(const std::string& scriptFile, const std::vector<std::string>& warpNames, const ZoneCounter& zoneCounter); // Zero when the script is missing
+    static std::string imagePath(const std::string& scriptFile);
+
+    bool open(const std::string& path); // Memory-mapped
+    bool load(std::vector<uint8_t> data);
+    void close();
+    void swap(ScriptImage& other);
+    bool isOpen() const { return m_data != nullptr; }
+    bool isMapped() const { return m_mapping != nullptr; }
+
+    const Source& source() const { return m_source; }
+    size_t byteSize() const { return m_size; }
+
+    uint32_t stringCount() const { return m_stringCount; }
+    uint32_t instructionCount() const { return m_instructionCount; }
+    uint32_t paramCount() const { return m_paramCount; }
+    uint32_t blockCount() const { return m_blockCount; }
+    const Block& block(uint32_t id) const { return m_blocks[id]; }
+    const Instruction& instruction(uint32_t index) const { return m_instructions[index]; }
+    uint32_t param(uint32_t index) const { return m_params[index]; }
+    std::string_view string(uint32_t id) const;
+    std::vector<std::string> params(const Instruction& instruction) const;
+
+    uint32_t variableCount() const { return m_variableCount; }
+    uint32_t variable(uint32_t index) const { return m_variables[index]; }
+
+    uint32_t warpCount() const { return m_warpCount; }
+    const Warp& warp(uint32_t index) const { return m_warps[index]; }
+    uint32_t zoneCount() const { return m_zoneCount; }
+    uint32_t zoneBlock(uint32_t index) const { return m_zones[index]; }
+
+private:
+    bool bind();
+
+private:
+    struct Mapping;
+
+    Mapping* m_mapping = nullptr;
+    std::vector<uint8_t> m_buffer;
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+    Source m_source;
+
+    const uint32_t* m_stringOffsets = nullptr;
+    const char* m_stringData = nullptr;
+    const Instruction* m_instructions = nullptr;
+    const uint32_t* m_params = nullptr;
+    const Block* m_blocks = nullptr;
+    const uint32_t* m_variables = nullptr;
+    const Warp* m_warps = nullptr;
+    const uint32_t* m_zones = nullptr;
+    uint32_t m_stringCount = 0;
+    uint32_t m_instructionCount = 0;
+    uint32_t m_paramCount = 0;
+    uint32_t m_blockCount = 0;
+    uint32_t m_variableCount = 0;
+    uint32_t m_warpCount = 0;
+    uint32_t m_zoneCount = 0;
+};
+
+#endif // ENGINE_SCRIPTIMAGE_H
@@ -0,0 +1,79 @@
+#include "scriptindex.h"
+
+#include "warpname.h"
+
+ScriptIndex::ScriptIndex()
+{
+}
+
+ScriptIndex::~ScriptIndex()
+{
+}
+
+void ScriptIndex::clear()
+{
+    m_warps.clear();
+    m_zoneBlocks.clear();
+    m_ids.clear();
+}
+
+int ScriptIndex::addWarp(const std::string& name, const Block& initBlock, const std::vector<Block>& zoneBlocks)
+{
+    const int existingId = findWarp(name);
+    if (existingId >= 0) {
+        return existingId;
+    }
+
+    Warp warp;
+    warp.name = name;
+    warp.initBlock = initBlock;
+    warp.firstZone = (uint32_t)m_zoneBlocks.size();
+    warp.zoneCount = (int)zoneBlocks.size();
+    m_zoneBlocks.insert(m_zoneBlocks.end(), zoneBlocks.begin(), zoneBlocks.end());
+
+    const int id = (int)m_warps.size();
+    m_warps.push_back(warp);
+    m_ids[normalizeWarpName(name)] = id;
+
+    return id;
+}
+
+int ScriptIndex::findWarp(const std::string& name) const
+{
+    auto it = m_ids.find(normalizeWarpName(name));
+    if (it == m_ids.end()) {
+        return -1;
+    }
+
+    return it->second;
+}
+
+const std::string& ScriptIndex::warpName(int id) const
+{
+    return m_warps[id].name;
+}
+
+const ScriptIndex::Block& ScriptIndex::initBlock(int id) const
+{
+    return m_warps[id].initBlock;
+}
+
+const ScriptIndex::Block* ScriptIndex::zoneBlock(int id, int zone) const
+{
+    const Warp& warp = m_warps[id];
+    if (zone < 0 || zone >= warp.zoneCount) {
+        return nullptr;
+    }
+
+    return &m_zoneBlocks[warp.firstZone + zone];
+}
+
+int ScriptIndex::zoneCount(int id) const
+{
+    return m_warps[id].zoneCount;
+}
+
+size_t ScriptIndex::warpCount() const
+{
+    return m_warps.size();
+}
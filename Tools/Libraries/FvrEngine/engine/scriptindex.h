@@ -0,0 +1,52 @@
+#ifndef ENGINE_SCRIPTINDEX_H
+#define ENGINE_SCRIPTINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "scriptimage.h"
+
+/*
+ * Script blocks of each warp by integer id.
+ * Warp names are looked up once, init and zone test blocks are then read
+ * from dense tables.
+ */
+class ScriptIndex {
+public:
+    struct Block {
+        uint32_t block = ScriptImage::EmptyBlock; // Script image block
+        uint32_t entry = 0; // Compiled program entry
+    };
+
+public:
+    ScriptIndex();
+    ~ScriptIndex();
+
+    void clear();
+
+    int addWarp(const std::string& name, const Block& initBlock, const std::vector<Block>& zoneBlocks);
+    int findWarp(const std::string& name) const; // Case insensitive, -1 when not indexed
+
+    const std::string& warpName(int id) const;
+    const Block& initBlock(int id) const;
+    const Block* zoneBlock(int id, int zone) const; // Null outside of the warp zones
+    int zoneCount(int id) const;
+    size_t warpCount() const;
+
+private:
+    struct Warp {
+        std::string name;
+        Block initBlock;
+        uint32_t firstZone = 0;
+        int zoneCount = 0;
+    };
+
+private:
+    std::vector<Warp> m_warps;
+    std::vector<Block> m_zoneBlocks;
+    std::unordered_map<std::string, int> m_ids;
+};
+
+#endif // ENGINE_SCRIPTINDEX_H
@@ -0,0 +1,102 @@
+#include "scriptprofiler.h"
+
+#include <algorithm>
+
+/* Constants */
+#define SCRIPT_PROFILER_SLOWEST 16 // Individual calls kept
+
+namespace {
+
+bool isFaster(const ScriptProfiler::Sample& a, const ScriptProfiler::Sample& b)
+{
+    return a.ns > b.ns;
+}
+
+} // namespace
+
+ScriptProfiler::ScriptProfiler()
+{
+}
+
+ScriptProfiler::~ScriptProfiler()
+{
+}
+
+void ScriptProfiler::clear()
+{
+    m_functions.clear();
+    m_blocks.clear();
+    m_slowest.clear();
+}
+
+bool ScriptProfiler::isEmpty() const
+{
+    return m_functions.empty() && m_blocks.empty();
+}
+
+void ScriptProfiler::addCall(uint32_t function, uint32_t block, uint32_t op, uint64_t ns)
+{
+    // Functions do not run script, all their time is their own
+    Entry& entry = m_functions[function];
+    entry.id = function;
+    entry.count++;
+    entry.inclusiveNs += ns;
+    entry.exclusiveNs += ns;
+
+    if (m_slowest.size() < SCRIPT_PROFILER_SLOWEST) {
+        m_slowest.push_back({ function, block, op, ns });
+        std::push_heap(m_slowest.begin(), m_slowest.end(), isFaster);
+    } else if (ns > m_slowest.front().ns) {
+        std::pop_heap(m_slowest.begin(), m_slowest.end(), isFaster);
+        m_slowest.back() = { function, block, op, ns };
+        std::push_heap(m_slowest.begin(), m_slowest.end(), isFaster);
+    }
+}
+
+void ScriptProfiler::addBlockRun(uint32_t block)
+{
+    Entry& entry = m_blocks[block];
+    entry.id = block;
+    entry.count++;
+}
+
+void ScriptProfiler::addBlockTime(uint32_t block, uint64_t ns, uint64_t calleeNs)
+{
+    Entry& entry = m_blocks[block];
+    entry.id = block;
+    entry.inclusiveNs += ns;
+    entry.exclusiveNs += ns > calleeNs ? ns - calleeNs : 0;
+}
+
+std::vector<ScriptProfiler::Entry> ScriptProfiler::functions() const
+{
+    return sorted(m_functions);
+}
+
+std::vector<ScriptProfiler::Entry> ScriptProfiler::blocks() const
+{
+    return sorted(m_blocks);
+}
+
+std::vector<ScriptProfiler::Sample> ScriptProfiler::slowest() const
+{
+    std::vector<Sample> samples = m_slowest;
+    std::sort_heap(samples.begin(), samples.end(), isFaster);
+
+    return samples;
+}
+
+std::vector<ScriptProfiler::Entry> ScriptProfiler::sorted(const std::unordered_map<uint32_t, Entry>& entries)
+{
+    std::vector<Entry> values;
+    values.reserve(entries.size());
+    for (const auto& entry : entries) {
+        values.push_back(entry.second);
+    }
+
+    std::sort(values.begin(), values.end(), [](const Entry& a, const Entry& b) {
+        return a.inclusiveNs > b.inclusiveNs;
+    });
+
+    return values;
+}
@@ -0,0 +1,57 @@
+#ifndef ENGINE_SCRIPTPROFILER_H
+#define ENGINE_SCRIPTPROFILER_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Call counts and wall time of script functions and blocks.
+ * Off by default, the interpreter then only checks isEnabled().
+ */
+class ScriptProfiler {
+public:
+    struct Entry {
+        uint32_t id = 0; // Function slot or block entry op
+        uint64_t count = 0;
+        uint64_t inclusiveNs = 0;
+        uint64_t exclusiveNs = 0; // Functions called by a block excluded
+    };
+
+    struct Sample {
+        uint32_t function = 0;
+        uint32_t block = 0;
+        uint32_t op = 0; // Offset from the block entry
+        uint64_t ns = 0;
+    };
+
+public:
+    ScriptProfiler();
+    ~ScriptProfiler();
+
+    void setEnabled(bool enabled) { m_isEnabled = enabled; }
+    bool isEnabled() const { return m_isEnabled; }
+
+    void clear();
+    bool isEmpty() const;
+
+    void addCall(uint32_t function, uint32_t block, uint32_t op, uint64_t ns);
+    void addBlockRun(uint32_t block);
+    void addBlockTime(uint32_t block, uint64_t ns, uint64_t calleeNs); // One slice between waits
+
+    // Sorted by inclusive time, slowest first
+    std::vector<Entry> functions() const;
+    std::vector<Entry> blocks() const;
+    std::vector<Sample> slowest() const;
+
+private:
+    static std::vector<Entry> sorted(const std::unordered_map<uint32_t, Entry>& entries);
+
+private:
+    bool m_isEnabled = false;
+    std::unordered_map<uint32_t, Entry> m_functions;
+    std::unordered_map<uint32_t, Entry> m_blocks;
+    std::vector<Sample> m_slowest; // Min-heap on time
+};
+
+#endif // ENGINE_SCRIPTPROFILER_H
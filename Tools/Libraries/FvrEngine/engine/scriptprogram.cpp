@@ -0,0 +1,163 @@
+#include "scriptprogram.h"
+
+ScriptProgram::ScriptProgram()
+{
+}
+
+ScriptProgram::~ScriptProgram()
+{
+}
+
+void ScriptProgram::clear()
+{
+    m_ops.clear();
+    m_operands.clear();
+    m_arguments.clear();
+    m_strings.clear();
+    m_stringIds.clear();
+    m_entries.clear();
+    m_blockCount = 0;
+    m_rejectedCount = 0;
+}
+
+uint32_t ScriptProgram::compile(const ScriptImage& image, uint32_t block, const Resolver& resolver)
+{
+    if (m_entries.size() < image.blockCount()) {
+        m_entries.resize(image.blockCount(), NoEntry);
+    }
+    if (m_entries[block] != NoEntry) {
+        return m_entries[block];
+    }
+
+    const uint32_t entry = (uint32_t)m_ops.size();
+    emitBlock(image, block, resolver, false, false);
+
+    Op op;
+    op.opcode = Opcode::Return;
+    m_ops.push_back(op);
+
+    m_entries[block] = entry;
+    m_blockCount++;
+
+    return entry;
+}
+
+void ScriptProgram::emitBlock(const ScriptImage& image, uint32_t block, const Resolver& resolver, bool isPlugin, bool isNested)
+{
+    // A return leaves the block it is in, the enclosing block goes on
+    std::vector<size_t> returnJumps;
+    const auto emitReturn = [this, isNested, &returnJumps]() {
+        Op op;
+        if (isNested) {
+            op.opcode = Opcode::Jump;
+            returnJumps.push_back(m_ops.size());
+        } else {
+            op.opcode = Opcode::Return;
+        }
+        m_ops.push_back(op);
+    };
+
+    const ScriptImage::Block& instructions = image.block(block);
+    for (uint32_t i = 0; i < instructions.instructionCount; i++) {
+        const ScriptImage::Instruction& instruction = image.instruction(instructions.firstInstruction + i);
+        const std::string_view name = image.string(instruction.name);
+        Op op;
+
+        if (isPlugin) {
+            emitCall(image, instruction, resolver, true);
+        } else if (name == "plugin") {
+            emitBlock(image, instruction.block, resolver, true, true);
+        } else if (name == "ifand" || name == "ifor") {
+            op.opcode = name == "ifand" ? Opcode::IfAnd : Opcode::IfOr;
+            op.first = (uint32_t)m_operands.size();
+            op.count = instruction.paramCount;
+            for (uint32_t param = 0; param < instruction.paramCount; param++) {
+                m_operands.push_back(intern(image.string(image.param(instruction.firstParam + param))));
+            }
+
+            const size_t ifIndex = m_ops.size();
+            m_ops.push_back(op);
+            emitBlock(image, instruction.block, resolver, false, true);
+            m_ops[ifIndex].target = (uint32_t)m_ops.size();
+        } else if (name == "return") {
+            emitReturn();
+        } else if (name == "end") {
+            op.opcode = Opcode::End;
+            m_ops.push_back(op);
+        } else if (emitCall(image, instruction, resolver, false) && name == "gotowarp") {
+            op.opcode = Opcode::EnterWarp;
+            m_ops.push_back(op);
+
+            // Rest of the block belongs to the warp being left, enclosing blocks go on
+            emitReturn();
+        }
+    }
+
+    for (size_t index : returnJumps) {
+        m_ops[index].target = (uint32_t)m_ops.size();
+    }
+}
+
+bool ScriptProgram::emitCall(const ScriptImage& image, const ScriptImage::Instruction& instruction, const Resolver& resolver, bool isPlugin)
+{
+    Arguments arguments;
+    const int slot = resolver(std::string(image.string(instruction.name)), isPlugin, image.params(instruction), arguments);
+    if (slot < 0) {
+        m_rejectedCount++;
+        return false;
+    }
+
+    Op op;
+    op.opcode = isPlugin ? Opcode::CallPlugin : Opcode::Call;
+    op.slot = (uint32_t)slot;
+    op.arguments = (uint32_t)m_arguments.size();
+    m_arguments.push_back(std::move(arguments));
+    m_ops.push_back(op);
+
+    return true;
+}
+
+uint32_t ScriptProgram::intern(std::string_view value)
+{
+    auto it = m_stringIds.find(std::string(value));
+    if (it != m_stringIds.end()) {
+        return it->second;
+    }
+
+    const uint32_t id = (uint32_t)m_strings.size();
+    m_strings.emplace_back(value);
+    m_stringIds[m_strings.back()] = id;
+
+    return id;
+}
+
+size_t ScriptProgram::blockCount() const
+{
+    return m_blockCount;
+}
+
+size_t ScriptProgram::opCount() const
+{
+    return m_ops.size();
+}
+
+size_t ScriptProgram::stringCount() const
+{
+    return m_strings.size();
+}
+
+size_t ScriptProgram::rejectedCount() const
+{
+    return m_rejectedCount;
+}
+
+size_t ScriptProgram::byteSize() const
+{
+    // Converted arguments are opaque, only their handles are counted
+    size_t size = m_ops.size() * sizeof(Op) + m_operands.size() * sizeof(uint32_t) + m_arguments.size() * sizeof(Arguments);
+    for (const std::string& value : m_strings) {
+        size += value.size();
+    }
+
+    return size;
+}
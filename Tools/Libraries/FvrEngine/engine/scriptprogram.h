@@ -0,0 +1,80 @@
+#ifndef ENGINE_SCRIPTPROGRAM_H
+#define ENGINE_SCRIPTPROGRAM_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "scriptimage.h"
+
+/*
+ * Flat bytecode of the LST script blocks.
+ * Function names are resolved to slots, if-blocks to jump targets and
+ * strings are interned, so running a block does no string comparison.
+ */
+class ScriptProgram {
+public:
+    enum class Opcode : uint8_t {
+        Call, // Core function
+        CallPlugin, // Plugin function
+        IfAnd, // Jumps to target unless every operand is set
+        IfOr, // Jumps to target unless an operand is set
+        Jump,
+        End,
+        EnterWarp, // Suspends until the warp of the previous gotowarp call is entered, then runs its init block
+        Return
+    };
+
+    struct Op {
+        Opcode opcode = Opcode::Return;
+        uint32_t slot = 0; // Function slot
+        uint32_t arguments = 0; // Converted arguments of a call
+        uint32_t first = 0; // First operand of an if
+        uint32_t count = 0; // Operand count of an if
+        uint32_t target = 0;
+    };
+
+    using Arguments = std::shared_ptr<const void>; // Converted by the function binding
+    using Resolver = std::function<int(const std::string& name, bool isPlugin, const std::vector<std::string>& params, Arguments& arguments)>; // Slot, -1 when the call is rejected
+
+public:
+    ScriptProgram();
+    ~ScriptProgram();
+
+    void clear();
+    uint32_t compile(const ScriptImage& image, uint32_t block, const Resolver& resolver); // Entry op, compiled once per block
+
+    const Op& op(uint32_t index) const { return m_ops[index]; }
+    const void* arguments(uint32_t index) const { return m_arguments[index].get(); }
+    uint32_t operand(uint32_t index) const { return m_operands[index]; }
+    const std::string& string(uint32_t index) const { return m_strings[index]; }
+
+    size_t blockCount() const;
+    size_t opCount() const;
+    size_t stringCount() const;
+    size_t byteSize() const;
+    size_t rejectedCount() const; // Calls left out, unknown function or invalid arguments
+
+private:
+    static constexpr uint32_t NoEntry = UINT32_MAX;
+
+    void emitBlock(const ScriptImage& image, uint32_t block, const Resolver& resolver, bool isPlugin, bool isNested);
+    bool emitCall(const ScriptImage& image, const ScriptImage::Instruction& instruction, const Resolver& resolver, bool isPlugin);
+    uint32_t intern(std::string_view value);
+
+private:
+    std::vector<Op> m_ops;
+    std::vector<uint32_t> m_operands;
+    std::vector<Arguments> m_arguments;
+    std::vector<std::string> m_strings;
+    std::unordered_map<std::string, uint32_t> m_stringIds;
+    std::vector<uint32_t> m_entries; // Per image block, NoEntry until compiled
+    size_t m_blockCount = 0;
+    size_t m_rejectedCount = 0;
+};
+
+#endif // ENGINE_SCRIPTPROGRAM_H
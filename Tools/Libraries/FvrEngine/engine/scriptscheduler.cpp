@@ -0,0 +1,207 @@
+#include "scriptscheduler.h"
+
+#include <algorithm>
+#include <utility>
+
+std::coroutine_handle<> ScriptTask::FinalAwaiter::await_suspend(Handle handle) noexcept
+{
+    // Back to the awaiting block, or to whoever resumed this one
+    if (handle.promise().continuation) {
+        return handle.promise().continuation;
+    }
+
+    return std::noop_coroutine();
+}
+
+ScriptTask::ScriptTask(Handle handle)
+    : m_handle(handle)
+{
+}
+
+ScriptTask::ScriptTask(ScriptTask&& other) noexcept
+    : m_handle(std::exchange(other.m_handle, nullptr))
+{
+}
+
+ScriptTask& ScriptTask::operator=(ScriptTask&& other) noexcept
+{
+    if (this != &other) {
+        if (m_handle) {
+            m_handle.destroy();
+        }
+        m_handle = std::exchange(other.m_handle, nullptr);
+    }
+
+    return *this;
+}
+
+ScriptTask::~ScriptTask()
+{
+    // Destroying a suspended block also destroys the blocks it awaits
+    if (m_handle) {
+        m_handle.destroy();
+    }
+}
+
+bool ScriptTask::isDone() const
+{
+    return !m_handle || m_handle.done();
+}
+
+bool ScriptTask::await_ready() const noexcept
+{
+    return isDone();
+}
+
+std::coroutine_handle<> ScriptTask::await_suspend(std::coroutine_handle<> awaiting) noexcept
+{
+    m_handle.promise().continuation = awaiting;
+
+    return m_handle;
+}
+
+void ScriptTask::await_resume() const
+{
+    if (m_handle && m_handle.promise().exception) {
+        std::rethrow_exception(m_handle.promise().exception);
+    }
+}
+
+ScriptScheduler::ScriptScheduler()
+{
+}
+
+ScriptScheduler::~ScriptScheduler()
+{
+    cancel();
+}
+
+void ScriptScheduler::run(ScriptTask task)
+{
+    if (task.isDone()) {
+        return;
+    }
+
+    // Requests made outside of a block are not awaited by it
+    m_request = nullptr;
+    m_block = task.m_handle;
+    task.m_handle.resume();
+    m_block = nullptr;
+    m_request = nullptr;
+
+    if (!task.isDone()) {
+        m_tasks.push_back(std::move(task));
+    }
+}
+
+void ScriptScheduler::request(const std::function<bool(double elapsed)>& update, const std::function<void()>& finish, bool isSkippable)
+{
+    WaitPtr wait = std::make_shared<Wait>();
+    wait->update = update;
+    wait->finish = finish;
+    wait->isSkippable = isSkippable;
+    wait->block = m_block;
+
+    m_waits.push_back(wait);
+    m_request = wait;
+}
+
+ScriptScheduler::WaitAwaiter ScriptScheduler::takeRequest()
+{
+    return { std::exchange(m_request, nullptr) };
+}
+
+void ScriptScheduler::update(double elapsedSeconds)
+{
+    std::vector<WaitPtr> overWaits;
+    for (const WaitPtr& wait : m_waits) {
+        wait->elapsed += elapsedSeconds;
+        if (wait->update(wait->elapsed)) {
+            overWaits.push_back(wait);
+        }
+    }
+
+    resume(overWaits);
+}
+
+bool ScriptScheduler::skip()
+{
+    std::vector<WaitPtr> skippedWaits;
+    for (const WaitPtr& wait : m_waits) {
+        if (wait->isSkippable) {
+            skippedWaits.push_back(wait);
+        }
+    }
+
+    resume(skippedWaits);
+
+    return !skippedWaits.empty();
+}
+
+void ScriptScheduler::resume(const std::vector<WaitPtr>& waits)
+{
+    // Resumed blocks may request new waits, so the list is not walked while resuming
+    for (const WaitPtr& wait : waits) {
+        wait->isOver = true;
+        m_waits.remove(wait);
+
+        if (wait->finish) {
+            wait->finish();
+        }
+    }
+
+    for (const WaitPtr& wait : waits) {
+        if (wait->awaiting) {
+            m_request = nullptr;
+            m_block = wait->block;
+            wait->awaiting.resume();
+            m_block = nullptr;
+            m_request = nullptr;
+        }
+    }
+
+    m_tasks.remove_if([](const ScriptTask& task) { return task.isDone(); });
+}
+
+void ScriptScheduler::cancel()
+{
+    m_request = nullptr;
+    m_waits.clear();
+    m_tasks.clear();
+}
+
+void ScriptScheduler::cancelSkippable()
+{
+    m_request = nullptr;
+
+    std::vector<std::coroutine_handle<>> blocks;
+    for (auto it = m_waits.begin(); it != m_waits.end();) {
+        if ((*it)->isSkippable) {
+            if ((*it)->block) {
+                blocks.push_back((*it)->block);
+            }
+            it = m_waits.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    m_tasks.remove_if([&blocks](const ScriptTask& task) {
+        return std::find(blocks.begin(), blocks.end(), task.m_handle) != blocks.end();
+    });
+}
+
+bool ScriptScheduler::isIdle() const
+{
+    return m_waits.empty();
+}
+
+size_t ScriptScheduler::blockCount() const
+{
+    return m_tasks.size();
+}
+
+size_t ScriptScheduler::waitCount() const
+{
+    return m_waits.size();
+}
@@ -0,0 +1,116 @@
+#ifndef ENGINE_SCRIPTSCHEDULER_H
+#define ENGINE_SCRIPTSCHEDULER_H
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <list>
+#include <memory>
+#include <vector>
+
+/*
+ * Resumable script block.
+ * Starts suspended, awaiting a nested block runs it in place and resumes the
+ * awaiting block once it is over.
+ */
+class ScriptTask {
+public:
+    struct promise_type;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        std::coroutine_handle<> await_suspend(Handle handle) noexcept;
+        void await_resume() const noexcept { }
+    };
+
+    struct promise_type {
+        std::coroutine_handle<> continuation; // Awaiting block
+        std::exception_ptr exception;
+
+        ScriptTask get_return_object() noexcept { return ScriptTask(Handle::from_promise(*this)); }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept { }
+        void unhandled_exception() noexcept { exception = std::current_exception(); }
+    };
+
+public:
+    ScriptTask() = default;
+    ScriptTask(ScriptTask&& other) noexcept;
+    ScriptTask& operator=(ScriptTask&& other) noexcept;
+    ~ScriptTask();
+
+    bool isDone() const;
+
+    // Awaiting a block from another one
+    bool await_ready() const noexcept;
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept;
+    void await_resume() const;
+
+private:
+    explicit ScriptTask(Handle handle);
+
+    friend class ScriptScheduler;
+
+private:
+    Handle m_handle;
+};
+
+/*
+ * Script blocks suspended on waits.
+ * Script functions request a wait, the running block awaits it and is resumed
+ * from the main loop once the wait is over or skipped. Waits requested outside
+ * of a block run on their own.
+ */
+class ScriptScheduler {
+public:
+    struct Wait {
+        std::function<bool(double elapsed)> update; // Returns true once the wait is over
+        std::function<void()> finish; // Called once over or skipped, not when cancelled
+        bool isSkippable = true;
+        bool isOver = false;
+        double elapsed = 0.0; // Seconds since the request
+        std::coroutine_handle<> awaiting; // Block to resume, none when not awaited
+        std::coroutine_handle<> block; // Outermost block that requested it, none outside of blocks
+    };
+    using WaitPtr = std::shared_ptr<Wait>;
+
+    struct WaitAwaiter {
+        WaitPtr wait;
+
+        bool await_ready() const noexcept { return !wait || wait->isOver; }
+        void await_suspend(std::coroutine_handle<> awaiting) noexcept { wait->awaiting = awaiting; }
+        void await_resume() const noexcept { }
+    };
+
+public:
+    ScriptScheduler();
+    ~ScriptScheduler();
+
+    void run(ScriptTask task); // Runs the block until its first wait
+
+    void request(const std::function<bool(double elapsed)>& update, const std::function<void()>& finish = nullptr, bool isSkippable = true);
+    WaitAwaiter takeRequest(); // Wait requested by the last script function, if any
+
+    void update(double elapsedSeconds);
+    bool skip(); // False when no wait can be skipped
+    void cancel(); // Drops every block and wait
+    void cancelSkippable(); // Drops the waits a click could skip and their blocks, others go on
+
+    bool isIdle() const;
+    size_t blockCount() const;
+    size_t waitCount() const;
+
+private:
+    void resume(const std::vector<WaitPtr>& waits);
+
+private:
+    std::list<ScriptTask> m_tasks;
+    std::list<WaitPtr> m_waits;
+    WaitPtr m_request;
+    std::coroutine_handle<> m_block; // Outermost block running
+
+};
+
+#endif // ENGINE_SCRIPTSCHEDULER_H
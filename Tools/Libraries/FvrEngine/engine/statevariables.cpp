@@ -0,0 +1,103 @@
+#include "statevariables.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+
+#include <ofnx/tools/log.h>
+
+StateVariables::StateVariables()
+{
+}
+
+StateVariables::~StateVariables()
+{
+}
+
+void StateVariables::clear()
+{
+    m_values.clear();
+    m_names.clear();
+    m_slots.clear();
+}
+
+int StateVariables::slot(const std::string& name)
+{
+    std::string key = normalize(name);
+
+    auto it = m_slots.find(key);
+    if (it != m_slots.end()) {
+        return it->second;
+    }
+
+    const int slot = (int)m_values.size();
+    m_values.push_back(0.0);
+    m_names.push_back(key);
+    m_slots[std::move(key)] = slot;
+
+    return slot;
+}
+
+int StateVariables::findSlot(const std::string& name) const
+{
+    auto it = m_slots.find(normalize(name));
+    if (it == m_slots.end()) {
+        return -1;
+    }
+
+    return it->second;
+}
+
+const std::string& StateVariables::name(int slot) const
+{
+    return m_names[slot];
+}
+
+size_t StateVariables::size() const
+{
+    return m_values.size();
+}
+
+double StateVariables::get(const std::string& name) const
+{
+    const int slot = findSlot(name);
+    if (slot < 0) {
+        return 0.0;
+    }
+
+    return m_values[slot];
+}
+
+void StateVariables::set(const std::string& name, double value)
+{
+    m_values[slot(name)] = value;
+}
+
+std::string StateVariables::getString(const std::string& name) const
+{
+    // Shortest form that reads back to the same value
+    char buffer[32];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), get(name));
+
+    return std::string(buffer, result.ptr);
+}
+
+void StateVariables::setString(const std::string& name, const std::string& value)
+{
+    double number = 0.0;
+    const auto result = std::from_chars(value.data(), value.data() + value.size(), number);
+    if (result.ec != std::errc()) {
+        LOG_ERROR("State value is not a number: {} = {}", name, value);
+    }
+
+    set(name, number);
+}
+
+std::string StateVariables::normalize(const std::string& name)
+{
+    std::string key = name;
+    std::transform(key.begin(), key.end(), key.begin(),
+        [](unsigned char c) { return std::tolower(c); });
+
+    return key;
+}
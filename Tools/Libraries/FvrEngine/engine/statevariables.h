@@ -0,0 +1,44 @@
+#ifndef ENGINE_STATEVARIABLES_H
+#define ENGINE_STATEVARIABLES_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Numeric script variables stored in a flat array.
+ * Names are case insensitive and resolved once to a slot, variables not
+ * declared by the script get a slot the first time they are used.
+ */
+class StateVariables {
+public:
+    StateVariables();
+    ~StateVariables();
+
+    void clear();
+
+    int slot(const std::string& name); // Declares the variable when unknown
+    int findSlot(const std::string& name) const; // -1 when unknown
+    const std::string& name(int slot) const;
+    size_t size() const;
+
+    double get(int slot) const { return m_values[slot]; }
+    void set(int slot, double value) { m_values[slot] = value; }
+
+    double get(const std::string& name) const; // 0 when unknown
+    void set(const std::string& name, double value);
+
+    // Compatibility with string values
+    std::string getString(const std::string& name) const;
+    void setString(const std::string& name, const std::string& value);
+
+private:
+    static std::string normalize(const std::string& name);
+
+private:
+    std::vector<double> m_values;
+    std::vector<std::string> m_names;
+    std::unordered_map<std::string, int> m_slots;
+};
+
+#endif // ENGINE_STATEVARIABLES_H
@@ -0,0 +1,91 @@
+#include "threadpool.h"
+
+#include <ofnx/tools/log.h>
+
+ThreadPool::ThreadPool()
+{
+}
+
+ThreadPool::~ThreadPool()
+{
+    deinit();
+}
+
+bool ThreadPool::init(int workerCount)
+{
+    deinit();
+
+    m_isStopping = false;
+    for (int i = 0; i < workerCount; i++) {
+        m_workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+
+    LOG_INFO("Thread pool started with {} worker(s)", workerCount);
+
+    return true;
+}
+
+void ThreadPool::deinit()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isStopping = true;
+    }
+    m_condition.notify_all();
+
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+    m_workers.clear();
+
+    // Run what is left so no future stays unsatisfied
+    while (!m_tasks.empty()) {
+        m_tasks.front()();
+        m_tasks.pop_front();
+    }
+}
+
+int ThreadPool::workerCount() const
+{
+    return (int)m_workers.size();
+}
+
+std::future<void> ThreadPool::submit(std::function<void()> task)
+{
+    std::packaged_task<void()> packagedTask(std::move(task));
+    std::future<void> future = packagedTask.get_future();
+
+    if (m_workers.empty()) {
+        packagedTask();
+        return future;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(packagedTask));
+    }
+    m_condition.notify_one();
+
+    return future;
+}
+
+void ThreadPool::workerLoop()
+{
+    while (true) {
+        std::packaged_task<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_isStopping || !m_tasks.empty(); });
+
+            if (m_isStopping && m_tasks.empty()) {
+                return;
+            }
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+
+        task();
+    }
+}
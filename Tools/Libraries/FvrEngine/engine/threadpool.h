@@ -0,0 +1,39 @@
+#ifndef ENGINE_THREADPOOL_H
+#define ENGINE_THREADPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Fixed size worker pool.
+ * Without workers, submitted tasks run immediately on the calling thread.
+ */
+class ThreadPool {
+public:
+    ThreadPool();
+    ~ThreadPool();
+
+    bool init(int workerCount);
+    void deinit();
+
+    int workerCount() const;
+
+    std::future<void> submit(std::function<void()> task);
+
+private:
+    void workerLoop();
+
+private:
+    std::vector<std::thread> m_workers;
+    std::deque<std::packaged_task<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_isStopping = false;
+};
+
+#endif // ENGINE_THREADPOOL_H
@@ -0,0 +1,232 @@
+#include "vranimationindex.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include <ofnx/tools/log.h>
+
+/* Constants (see Doc/Formats/VR.md) */
+#define VR_HEADER 0x12fa84ab
+#define VR_CHUNK_ANIMATION 0xa0b1c201
+#define VR_CHUNK_FRAME 0xa0b1c211
+#define VR_FRAME_EMPTY_SIZE 8
+#define VR_BLOCK_SIZE 8
+
+namespace {
+uint32_t readU32(const std::vector<uint8_t>& data, size_t offset)
+{
+    uint32_t value;
+    std::memcpy(&value, data.data() + offset, sizeof(value));
+    return value;
+}
+
+bool fits(const std::vector<uint8_t>& data, size_t offset, size_t size)
+{
+    return offset <= data.size() && size <= data.size() - offset;
+}
+}
+
+VrAnimationIndex::VrAnimationIndex()
+{
+}
+
+VrAnimationIndex::~VrAnimationIndex()
+{
+}
+
+bool VrAnimationIndex::load(const std::string& vrFile)
+{
+    std::ifstream file(vrFile, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    return load(data);
+}
+
+bool VrAnimationIndex::load(const std::vector<uint8_t>& data)
+{
+    clear();
+
+    if (!fits(data, 0, 8) || readU32(data, 0) != VR_HEADER) {
+        LOG_ERROR("Invalid VR header");
+        return false;
+    }
+
+    // Chunks (type, size including the 8 header bytes) follow the file header
+    size_t offset = 8;
+    while (fits(data, offset, 8)) {
+        const uint32_t chunkType = readU32(data, offset);
+        const uint32_t chunkSize = readU32(data, offset + 4);
+        if (chunkSize < 8 || !fits(data, offset, chunkSize)) {
+            break;
+        }
+
+        if (chunkType == VR_CHUNK_ANIMATION) {
+            const size_t chunkEnd = offset + chunkSize;
+
+            // Name field is documented as 20 bytes but seen as 32 bytes: use the one followed by a frame chunk
+            size_t nameSize = 0;
+            for (size_t candidate : { 20, 32 }) {
+                const size_t frameOffset = offset + 8 + candidate + 4;
+                if (fits(data, frameOffset, 4) && frameOffset + 4 <= chunkEnd && readU32(data, frameOffset) == VR_CHUNK_FRAME) {
+                    nameSize = candidate;
+                    break;
+                }
+            }
+
+            if (nameSize == 0) {
+                offset += chunkSize;
+                continue;
+            }
+
+            Animation animation;
+            const char* name = reinterpret_cast<const char*>(data.data() + offset + 8);
+            animation.name = std::string(name, strnlen(name, nameSize));
+
+            uint32_t frameCount = readU32(data, offset + 8 + nameSize);
+            size_t frameOffset = offset + 8 + nameSize + 4;
+            for (uint32_t i = 0; i < frameCount; i++) {
+                if (!fits(data, frameOffset, 8) || readU32(data, frameOffset) != VR_CHUNK_FRAME) {
+                    LOG_ERROR("Invalid VR animation frame: {}", animation.name);
+                    break;
+                }
+
+                const uint32_t frameSize = readU32(data, frameOffset + 4);
+                if (frameSize < VR_FRAME_EMPTY_SIZE || frameOffset + frameSize > chunkEnd) {
+                    break;
+                }
+
+                Frame frame;
+                if (frameSize > VR_FRAME_EMPTY_SIZE && fits(data, frameOffset + 8, 4)) {
+                    const uint32_t blockCount = readU32(data, frameOffset + 8);
+                    if (fits(data, frameOffset + 12, (size_t)blockCount * 4)) {
+                        frame.blockOffsets.resize(blockCount);
+                        std::memcpy(frame.blockOffsets.data(), data.data() + frameOffset + 12, (size_t)blockCount * 4);
+                    }
+                }
+
+                animation.footprint.insert(animation.footprint.end(), frame.blockOffsets.begin(), frame.blockOffsets.end());
+                animation.frames.push_back(std::move(frame));
+
+                frameOffset += frameSize;
+            }
+
+            std::sort(animation.footprint.begin(), animation.footprint.end());
+            animation.footprint.erase(std::unique(animation.footprint.begin(), animation.footprint.end()), animation.footprint.end());
+
+            m_animations.push_back(std::move(animation));
+        }
+
+        offset += chunkSize;
+    }
+
+    return true;
+}
+
+void VrAnimationIndex::clear()
+{
+    m_animations.clear();
+    m_isDecoded = false;
+}
+
+const std::vector<VrAnimationIndex::Animation>& VrAnimationIndex::animations() const
+{
+    return m_animations;
+}
+
+const VrAnimationIndex::Animation* VrAnimationIndex::animation(const std::string& name) const
+{
+    const auto sameChar = [](char a, char b) {
+        return std::tolower((unsigned char)a) == std::tolower((unsigned char)b);
+    };
+
+    for (const Animation& animation : m_animations) {
+        if (std::ranges::equal(animation.name, name, sameChar)) {
+            return &animation;
+        }
+    }
+
+    return nullptr;
+}
+
+bool VrAnimationIndex::decodeFrames(ofnx::files::Vr& fileVr, const std::vector<uint16_t>& image, int width)
+{
+    if (width < VR_BLOCK_SIZE) {
+        return false;
+    }
+
+    // Every block must lie inside the image
+    const size_t blockEnd = (size_t)(VR_BLOCK_SIZE - 1) * width + VR_BLOCK_SIZE;
+    for (const Animation& animation : m_animations) {
+        for (uint32_t blockOffset : animation.footprint) {
+            if (blockOffset % width > (uint32_t)(width - VR_BLOCK_SIZE) || blockOffset + blockEnd > image.size()) {
+                LOG_ERROR("VR animation block out of image: {}", animation.name);
+                return false;
+            }
+        }
+    }
+
+    // Frames are applied in playback order on a scratch copy, then their blocks are kept
+    std::vector<uint16_t> scratch = image;
+    for (Animation& animation : m_animations) {
+        animation.tileMask = 0;
+        for (uint32_t blockOffset : animation.footprint) {
+            const uint32_t tile = blockOffset / width / width;
+            if (tile < 32) {
+                animation.tileMask |= 1u << tile;
+            }
+        }
+
+        for (Frame& frame : animation.frames) {
+            fileVr.applyAnimationFrameRgb565(animation.name, scratch.data());
+
+            frame.tiles.resize(frame.blockOffsets.size() * VR_BLOCK_SIZE * VR_BLOCK_SIZE);
+            uint16_t* tile = frame.tiles.data();
+            for (uint32_t blockOffset : frame.blockOffsets) {
+                for (int row = 0; row < VR_BLOCK_SIZE; row++) {
+                    std::memcpy(tile, scratch.data() + blockOffset + row * width, VR_BLOCK_SIZE * sizeof(uint16_t));
+                    tile += VR_BLOCK_SIZE;
+                }
+            }
+        }
+    }
+
+    m_isDecoded = true;
+
+    return true;
+}
+
+bool VrAnimationIndex::isDecoded() const
+{
+    return m_isDecoded;
+}
+
+void VrAnimationIndex::applyFrame(const Frame& frame, uint16_t* image, int width)
+{
+    const uint16_t* tile = frame.tiles.data();
+    for (uint32_t blockOffset : frame.blockOffsets) {
+        for (int row = 0; row < VR_BLOCK_SIZE; row++) {
+            std::memcpy(image + blockOffset + row * width, tile, VR_BLOCK_SIZE * sizeof(uint16_t));
+            tile += VR_BLOCK_SIZE;
+        }
+    }
+}
+
+size_t VrAnimationIndex::byteSize() const
+{
+    size_t size = 0;
+    for (const Animation& animation : m_animations) {
+        for (const Frame& frame : animation.frames) {
+            size += frame.blockOffsets.size() * sizeof(uint32_t) + frame.tiles.size() * sizeof(uint16_t);
+        }
+        size += animation.footprint.size() * sizeof(uint32_t);
+    }
+
+    return size;
+}
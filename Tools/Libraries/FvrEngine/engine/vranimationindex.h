@@ -0,0 +1,51 @@
+#ifndef ENGINE_VRANIMATIONINDEX_H
+#define ENGINE_VRANIMATIONINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <ofnx/files/vr.h>
+
+/*
+ * Animation layout of a VR file (names, frames and block offsets).
+ * Only chunk headers are read, frames can then be decoded once into packed
+ * tiles with ofnx::files::Vr and applied as plain block copies.
+ */
+class VrAnimationIndex {
+public:
+    struct Frame {
+        std::vector<uint32_t> blockOffsets; // Pixel offset of each 8x8 block
+        std::vector<uint16_t> tiles; // RGB565 8x8 tiles in block order, once decoded
+    };
+
+    struct Animation {
+        std::string name;
+        std::vector<Frame> frames;
+        std::vector<uint32_t> footprint; // Sorted union of all frames block offsets
+        uint32_t tileMask = 0; // Square tiles of image width touched by the footprint, bit per tile, once decoded
+    };
+
+public:
+    VrAnimationIndex();
+    ~VrAnimationIndex();
+
+    bool load(const std::string& vrFile);
+    bool load(const std::vector<uint8_t>& data);
+    void clear();
+
+    const std::vector<Animation>& animations() const;
+    const Animation* animation(const std::string& name) const;
+
+    bool decodeFrames(ofnx::files::Vr& fileVr, const std::vector<uint16_t>& image, int width);
+    bool isDecoded() const;
+    static void applyFrame(const Frame& frame, uint16_t* image, int width);
+
+    size_t byteSize() const;
+
+private:
+    std::vector<Animation> m_animations;
+    bool m_isDecoded = false;
+};
+
+#endif // ENGINE_VRANIMATIONINDEX_H
@@ -0,0 +1,144 @@
+#include "warpcache.h"
+
+#include "warpname.h"
+
+namespace {
+size_t entrySize(const WarpCache::RawPtr& data)
+{
+    return data->size();
+}
+
+size_t entrySize(const WarpCache::DecodedPtr& warp)
+{
+    return warp->image.size() * sizeof(uint16_t) + (warp->animationIndex ? warp->animationIndex->byteSize() : 0);
+}
+}
+
+WarpCache::WarpCache()
+{
+}
+
+WarpCache::~WarpCache()
+{
+}
+
+void WarpCache::setBudget(size_t rawBytes, size_t decodedBytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_raw.stats.budget = rawBytes;
+    m_decoded.stats.budget = decodedBytes;
+
+    trim(m_raw);
+    trim(m_decoded);
+}
+
+void WarpCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_raw.entries.clear();
+    m_raw.index.clear();
+    m_raw.stats.bytes = 0;
+
+    m_decoded.entries.clear();
+    m_decoded.index.clear();
+    m_decoded.stats.bytes = 0;
+}
+
+WarpCache::RawPtr WarpCache::getRaw(const std::string& warpName)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return get(m_raw, warpName);
+}
+
+void WarpCache::putRaw(const std::string& warpName, RawPtr data)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    put(m_raw, warpName, std::move(data));
+}
+
+WarpCache::DecodedPtr WarpCache::getDecoded(const std::string& warpName)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return get(m_decoded, warpName);
+}
+
+bool WarpCache::containsDecoded(const std::string& warpName) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_decoded.index.contains(normalizeWarpName(warpName));
+}
+
+void WarpCache::putDecoded(const std::string& warpName, DecodedPtr warp)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    put(m_decoded, warpName, std::move(warp));
+}
+
+WarpCache::Stats WarpCache::rawStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_raw.stats;
+}
+
+WarpCache::Stats WarpCache::decodedStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_decoded.stats;
+}
+
+template <typename Value>
+Value WarpCache::get(Tier<Value>& tier, const std::string& warpName)
+{
+    auto it = tier.index.find(normalizeWarpName(warpName));
+    if (it == tier.index.end()) {
+        tier.stats.misses++;
+        return nullptr;
+    }
+
+    // Move to front
+    tier.entries.splice(tier.entries.begin(), tier.entries, it->second);
+    tier.stats.hits++;
+
+    return it->second->second;
+}
+
+template <typename Value>
+void WarpCache::put(Tier<Value>& tier, const std::string& warpName, Value value)
+{
+    if (!value) {
+        return;
+    }
+
+    const std::string key = normalizeWarpName(warpName);
+    auto it = tier.index.find(key);
+    if (it != tier.index.end()) {
+        tier.stats.bytes -= entrySize(it->second->second);
+        tier.entries.erase(it->second);
+        tier.index.erase(it);
+    }
+
+    // Entry would not fit even in an empty tier
+    const size_t size = entrySize(value);
+    if (size > tier.stats.budget) {
+        return;
+    }
+
+    tier.entries.emplace_front(key, std::move(value));
+    tier.index[key] = tier.entries.begin();
+    tier.stats.bytes += size;
+
+    trim(tier);
+}
+
+template <typename Value>
+void WarpCache::trim(Tier<Value>& tier)
+{
+    while (tier.stats.bytes > tier.stats.budget && !tier.entries.empty()) {
+        tier.stats.bytes -= entrySize(tier.entries.back().second);
+        tier.index.erase(tier.entries.back().first);
+        tier.entries.pop_back();
+        tier.stats.evictions++;
+    }
+}
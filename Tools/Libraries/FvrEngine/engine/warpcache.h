@@ -0,0 +1,83 @@
+#ifndef ENGINE_WARPCACHE_H
+#define ENGINE_WARPCACHE_H
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <ofnx/files/tst.h>
+
+#include "vranimationindex.h"
+
+/*
+ * Warp data cache keyed by warp name, with two LRU tiers each bounded by a
+ * byte budget: raw VR file bytes and decoded RGB565 images.
+ * Entries are shared read-only, all methods are thread-safe.
+ */
+class WarpCache {
+public:
+    struct DecodedWarp {
+        bool isPanoramic = false;
+        std::vector<uint16_t> image;
+        std::shared_ptr<const VrAnimationIndex> animationIndex; // Shared with the current warp, animations are played from the VR file if null
+        std::shared_ptr<ofnx::files::Tst> zones; // Null if the warp has no TST file
+        int zoneCount = 0;
+    };
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        size_t bytes = 0;
+        size_t budget = 0;
+    };
+
+    using RawPtr = std::shared_ptr<const std::vector<uint8_t>>;
+    using DecodedPtr = std::shared_ptr<const DecodedWarp>;
+
+public:
+    WarpCache();
+    ~WarpCache();
+
+    void setBudget(size_t rawBytes, size_t decodedBytes);
+    void clear();
+
+    // Warp names are case insensitive
+    RawPtr getRaw(const std::string& warpName);
+    void putRaw(const std::string& warpName, RawPtr data);
+
+    DecodedPtr getDecoded(const std::string& warpName);
+    bool containsDecoded(const std::string& warpName) const; // Does not touch LRU order nor stats
+    void putDecoded(const std::string& warpName, DecodedPtr warp);
+
+    Stats rawStats() const;
+    Stats decodedStats() const;
+
+private:
+    template <typename Value>
+    struct Tier {
+        using Entry = std::pair<std::string, Value>;
+
+        std::list<Entry> entries; // Most recently used first
+        std::unordered_map<std::string, typename std::list<Entry>::iterator> index;
+        Stats stats;
+    };
+
+    template <typename Value>
+    static Value get(Tier<Value>& tier, const std::string& warpName);
+    template <typename Value>
+    static void put(Tier<Value>& tier, const std::string& warpName, Value value);
+    template <typename Value>
+    static void trim(Tier<Value>& tier);
+
+private:
+    mutable std::mutex m_mutex;
+    Tier<RawPtr> m_raw;
+    Tier<DecodedPtr> m_decoded;
+};
+
+#endif // ENGINE_WARPCACHE_H
@@ -0,0 +1,18 @@
+#ifndef ENGINE_WARPNAME_H
+#define ENGINE_WARPNAME_H
+
+#include <algorithm>
+#include <cctype>
+#include <string>
+
+// Key of a warp in the engine tables, script and file names differ in case
+inline std::string normalizeWarpName(const std::string& warpName)
+{
+    std::string key = warpName;
+    std::transform(key.begin(), key.end(), key.begin(),
+        [](unsigned char c) { return std::tolower(c); });
+
+    return key;
+}
+
+#endif // ENGINE_WARPNAME_H